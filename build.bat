@@ -1,4 +1,9 @@
 @echo off
-emcc src/main.cpp -sWASM=1 -sUSE_WEBGL2=1 -sMIN_WEBGL_VERSION=2 -sMAX_WEBGL_VERSION=2 -o public/bin/main.js
+rem Usage: build.bat [debug]
+rem Debug builds add -DGL_STATS (GL call counters, overlay and getGLStats())
+rem and -DTRACING (trace zones, exported by getTraceJSON()).
+set FLAGS=-O3 -msimd128
+if "%1"=="debug" set FLAGS=-O1 -g -msimd128 -DGL_STATS -DTRACING
+emcc src/main.cpp src/sim.cpp src/course.cpp src/course_check.cpp src/course_file.cpp src/snapshot.cpp src/rewind.cpp src/state_hash.cpp src/ballistics.cpp src/fast_forward.cpp src/replay.cpp src/world_batch.cpp src/search_bot.cpp src/gl_stats.cpp src/gl_state.cpp src/profiler.cpp src/trace.cpp %FLAGS% -sWASM=1 -sEXPORTED_FUNCTIONS=_main,_malloc,_free -sEXPORTED_RUNTIME_METHODS=HEAPU8,UTF8ToString -sMIN_WEBGL_VERSION=1 -sMAX_WEBGL_VERSION=2 -o public/bin/main.js
 echo Build complete!
 pause
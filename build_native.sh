@@ -0,0 +1,17 @@
+#!/bin/sh
+# Native (Linux) build of the headless simulation runner. No Emscripten or GL required.
+# -ffp-contract=off keeps float results identical to the wasm build (no FMA fusion).
+# ARCH_FLAGS selects the SIMD level for the batch kernel (default: the build machine's).
+# -pthread: the replay verifier and its submission endpoint use all cores.
+# Extra CXXFLAGS are passed through, e.g. CXXFLAGS=-DTRACING to compile in trace zones.
+set -e
+mkdir -p build
+${CXX:-g++} -std=c++17 -O3 ${ARCH_FLAGS:--march=native} -ffp-contract=off -pthread -Wall ${CXXFLAGS} \
+    src/sim.cpp src/course.cpp src/course_check.cpp src/course_file.cpp src/snapshot.cpp src/rewind.cpp src/state_hash.cpp src/ballistics.cpp src/fast_forward.cpp src/replay.cpp src/world_batch.cpp \
+    src/verifier.cpp src/work_pool.cpp src/submission.cpp src/gym.cpp src/search_bot.cpp \
+    src/trace.cpp src/headless.cpp -o build/headless
+# The gym API (src/gym.h) as a shared library, for training agents from other languages
+${CXX:-g++} -std=c++17 -O3 ${ARCH_FLAGS:--march=native} -ffp-contract=off -fPIC -shared -Wall ${CXXFLAGS} \
+    src/sim.cpp src/course.cpp src/course_file.cpp src/ballistics.cpp src/trace.cpp src/gym.cpp \
+    -o build/libgym.so
+echo Build complete!
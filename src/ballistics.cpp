@@ -0,0 +1,179 @@
+#include "ballistics.h"
+
+#include <cmath>
+
+#include "collision.h"
+
+// Raw (unclamped) height of the arc after n ticks of flight
+static float rawHeight(const JumpArc& arc, const SimConfig& config, uint64_t n) {
+    return arc.launchY + arcOffset(config, arc.launchVelocity, uint32_t(n));
+}
+
+// Solve launchY + (v0 + g t / 2) t 60 = y for t (seconds). Returns false
+// if the arc never reaches y; otherwise t0 <= t1 are the two crossings.
+static bool solveArc(const JumpArc& arc, const SimConfig& config, float y,
+                     double& t0, double& t1) {
+    double a = 30.0 * config.gravity;
+    double b = 60.0 * arc.launchVelocity;
+    double c = double(arc.launchY) - y;
+    if (a == 0.0) {
+        return false;
+    }
+    double disc = b * b - 4.0 * a * c;
+    if (disc < 0.0) {
+        return false;
+    }
+    double root = std::sqrt(disc);
+    double r0 = (-b + root) / (2.0 * a);
+    double r1 = (-b - root) / (2.0 * a);
+    t0 = std::fmin(r0, r1);
+    t1 = std::fmax(r0, r1);
+    return true;
+}
+
+JumpArc currentArc(const SimState& state) {
+    return {state.tick - state.airTicks, state.launchY, state.launchVelocity};
+}
+
+JumpArc jumpArcAt(const SimConfig& config, uint64_t tick) {
+    return {tick, config.groundY, config.jumpVelocity};
+}
+
+float arcHeight(const JumpArc& arc, const SimConfig& config, uint64_t tick) {
+    if (tick <= arc.launchTick) {
+        return arc.launchY;
+    }
+    // The arc is concave, so once it drops below the ground it stays there
+    // and the simulation holds the player on the ground.
+    float y = rawHeight(arc, config, tick - arc.launchTick);
+    return y < config.groundY ? config.groundY : y;
+}
+
+uint64_t arcLandingTick(const JumpArc& arc, const SimConfig& config) {
+    double t0, t1;
+    if (config.gravity >= 0.0f || !solveArc(arc, config, config.groundY, t0, t1)) {
+        return UINT64_MAX;
+    }
+
+    // Estimate from the later crossing, then settle on the exact first
+    // tick the simulation sees below the ground.
+    auto below = [&](uint64_t n) { return rawHeight(arc, config, n) < config.groundY; };
+    double estimate = std::floor(t1 * config.tickRate);
+    uint64_t n = estimate < 1.0 ? 1 : uint64_t(estimate);
+    while (n > 1 && below(n - 1)) {
+        --n;
+    }
+    while (!below(n)) {
+        ++n;
+    }
+    return arc.launchTick + n;
+}
+
+bool arcTicksAbove(const JumpArc& arc, const SimConfig& config, float minY,
+                   uint64_t& first, uint64_t& last) {
+    double t0, t1;
+    if (!solveArc(arc, config, minY, t0, t1) || t1 <= 0.0) {
+        return false;
+    }
+    uint64_t landing = arcLandingTick(arc, config);
+    if (landing == UINT64_MAX) {
+        return false;
+    }
+    uint64_t flight = landing - arc.launchTick; // ticks 1 .. flight-1 are airborne
+    if (flight < 2) {
+        return false;
+    }
+
+    // Estimates from the real roots, corrected against the exact heights.
+    // The arc is concave, so the ticks at or above minY are contiguous.
+    auto above = [&](uint64_t n) { return rawHeight(arc, config, n) >= minY; };
+    double loEstimate = std::ceil(t0 * config.tickRate);
+    double hiEstimate = std::floor(t1 * config.tickRate);
+    uint64_t lo = loEstimate < 1.0 ? 1 : uint64_t(loEstimate);
+    uint64_t hi = hiEstimate > double(flight - 1) ? flight - 1 : uint64_t(hiEstimate);
+    if (lo > flight - 1 || hiEstimate < 1.0) {
+        return false;
+    }
+    while (lo > 1 && above(lo - 1)) {
+        --lo;
+    }
+    while (lo <= hi && !above(lo)) {
+        ++lo;
+    }
+    while (hi < flight - 1 && above(hi + 1)) {
+        ++hi;
+    }
+    while (hi >= lo && !above(hi)) {
+        --hi;
+    }
+    if (lo > hi) {
+        return false;
+    }
+    first = arc.launchTick + lo;
+    last = arc.launchTick + hi;
+    return true;
+}
+
+bool firstSpikeContactTick(const SimState& state, const SimConfig& config, size_t index,
+                           uint64_t& tick) {
+    const float step = simSpikeStep(config);
+    // Spikes that don't move left never reach the player (and the tick
+    // estimates below would divide by zero)
+    if (index >= state.spikes.size() || !(step > 0.0f)) {
+        return false;
+    }
+    const Spike& spike = state.spikes[index];
+    const uint64_t now = state.tick;
+    const JumpArc arc = currentArc(state);
+
+    // The exact test simUpdate() makes on tick k, and the part of it that
+    // depends on x alone (the spike's sweep over the tick spans the hit width)
+    auto touches = [&](uint64_t k) {
+        return collideSwept(simSpikeX(config, spike, k - 1), simSpikeX(config, spike, k), spike.y,
+                            arcHeight(arc, config, k - 1), arcHeight(arc, config, k));
+    };
+    auto spansX = [&](uint64_t k) {
+        return sweptSpans(simSpikeX(config, spike, k - 1), simSpikeX(config, spike, k),
+                          simHitHalfWidth);
+    };
+
+    // Ticks whose sweep spans the player's column, estimated from the
+    // spike's age and corrected against the exact positions
+    double enter = std::ceil((simSpikeSpawnX - simHitHalfWidth) / step) + double(spike.spawnTick);
+    double leave = std::floor((simSpikeSpawnX + simHitHalfWidth) / step) + double(spike.spawnTick) + 1.0;
+    uint64_t lo = enter < double(now + 1) ? now + 1 : uint64_t(enter);
+    uint64_t hi = leave < double(now) ? now : uint64_t(leave);
+    while (spansX(hi + 1)) {
+        ++hi;
+    }
+    while (lo > now + 1 && spansX(lo - 1)) {
+        --lo;
+    }
+    while (lo <= hi && !spansX(lo)) {
+        ++lo;
+    }
+    while (hi >= lo && !spansX(hi)) {
+        --hi;
+    }
+
+    // Ticks that start and end well clear above the spike can't touch it
+    // (the margin absorbs rounding); test the rest exactly. At most a
+    // couple of ticks are tested on either side of the clear stretch.
+    uint64_t clearFirst = 1, clearLast = 0;
+    uint64_t aboveFirst, aboveLast;
+    if (arcTicksAbove(arc, config, spike.y + simHitClearance + 1e-4f, aboveFirst, aboveLast)) {
+        clearFirst = aboveFirst + 1;
+        clearLast = aboveLast;
+    }
+    for (uint64_t k = lo; k <= hi; ++k) {
+        if (k >= clearFirst && k <= clearLast) {
+            k = clearLast;
+            continue;
+        }
+        if (touches(k)) {
+            tick = k;
+            return true;
+        }
+    }
+    return false;
+}
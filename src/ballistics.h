@@ -0,0 +1,75 @@
+#pragma once
+
+#include <cstdint>
+
+#include "sim.h"
+
+// ------------------------------------------------------
+// Closed-form jump model.
+// The player follows the exact parabola set by gravity and jumpVelocity,
+// sampled at tick times, instead of integrating velocity step by step:
+// after n ticks of flight the height is
+//     launchY + (v0 + g * t / 2) * t * 60,   t = n / tickRate
+// (v0 and g use the per-60 Hz-frame units of SimConfig). simUpdate()
+// evaluates arcOffset() itself, so the queries below predict the
+// simulation exactly, in O(1), and trajectories no longer depend on the
+// tick rate.
+//
+// Ticks in this API are values of SimState::tick: "at tick k" means the
+// state after k ticks have been simulated.
+// ------------------------------------------------------
+
+// One ballistic flight
+struct JumpArc {
+    uint64_t launchTick;  // SimState::tick when the flight started
+    float launchY;
+    float launchVelocity; // per 60 Hz frame
+};
+
+// Seconds of flight after `ticks` ticks
+inline float arcTime(const SimConfig& config, uint32_t ticks) {
+    return float(ticks) * float(1.0 / config.tickRate);
+}
+
+// Height gained after t seconds of flight. Every caller, including the
+// simulation, goes through this expression, so results are bit-identical
+// to stepping.
+inline float arcOffsetAt(float launchVelocity, float gravity, float t) {
+    return (launchVelocity + 0.5f * gravity * t) * t * 60.0f;
+}
+
+inline float arcOffset(const SimConfig& config, float launchVelocity, uint32_t ticks) {
+    return arcOffsetAt(launchVelocity, config.gravity, arcTime(config, ticks));
+}
+
+// Vertical velocity (per 60 Hz frame) after `ticks` ticks of flight
+inline float arcVelocity(const SimConfig& config, float launchVelocity, uint32_t ticks) {
+    return launchVelocity + config.gravity * arcTime(config, ticks);
+}
+
+// The arc the player is currently following. While standing on the
+// ground this is a zero-velocity arc that lands on the next tick.
+JumpArc currentArc(const SimState& state);
+
+// The arc of a jump from the ground whose input is applied on the update
+// that starts at `tick`.
+JumpArc jumpArcAt(const SimConfig& config, uint64_t tick);
+
+// Predicted player height at `tick` (>= arc.launchTick), assuming no input
+// changes the arc; the ground height once it has landed.
+float arcHeight(const JumpArc& arc, const SimConfig& config, uint64_t tick);
+
+// Tick at which the arc touches down (the player is on the ground again
+// and a jump input can take effect on the following update).
+uint64_t arcLandingTick(const JumpArc& arc, const SimConfig& config);
+
+// Range [first, last] of in-flight ticks whose height is >= minY.
+// Returns false if the arc never reaches minY before landing.
+bool arcTicksAbove(const JumpArc& arc, const SimConfig& config, float minY,
+                   uint64_t& first, uint64_t& last);
+
+// First tick at which the player touches spike `index` (0 = leftmost), if
+// nothing changes the player's arc and no earlier collision resets the
+// game. Returns false if they never touch, as when the spikes don't scroll.
+bool firstSpikeContactTick(const SimState& state, const SimConfig& config, size_t index,
+                           uint64_t& tick);
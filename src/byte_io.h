@@ -0,0 +1,103 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+// ------------------------------------------------------
+// Little-endian serialization helpers shared by the file formats
+// (replays, course files)
+// ------------------------------------------------------
+inline void writeU32(std::vector<uint8_t>& out, uint32_t v) {
+    for (int i = 0; i < 4; ++i) {
+        out.push_back(uint8_t(v >> (8 * i)));
+    }
+}
+
+inline void writeU64(std::vector<uint8_t>& out, uint64_t v) {
+    for (int i = 0; i < 8; ++i) {
+        out.push_back(uint8_t(v >> (8 * i)));
+    }
+}
+
+inline void writeF32(std::vector<uint8_t>& out, float v) {
+    uint32_t bits;
+    memcpy(&bits, &v, sizeof(bits));
+    writeU32(out, bits);
+}
+
+inline void writeF64(std::vector<uint8_t>& out, double v) {
+    uint64_t bits;
+    memcpy(&bits, &v, sizeof(bits));
+    writeU64(out, bits);
+}
+
+// Unsigned LEB128: 7 bits per byte, low bits first, high bit set on all
+// but the last byte
+inline void writeVarint(std::vector<uint8_t>& out, uint64_t v) {
+    while (v >= 0x80) {
+        out.push_back(uint8_t(v) | 0x80);
+        v >>= 7;
+    }
+    out.push_back(uint8_t(v));
+}
+
+struct ByteReader {
+    const uint8_t* data;
+    size_t size;
+    size_t pos;
+    bool ok;
+
+    bool has(size_t n) {
+        if (size - pos < n) {
+            ok = false;
+        }
+        return ok;
+    }
+    uint8_t u8() {
+        return has(1) ? data[pos++] : 0;
+    }
+    uint32_t u32() {
+        uint32_t v = 0;
+        if (has(4)) {
+            for (int i = 0; i < 4; ++i) {
+                v |= uint32_t(data[pos++]) << (8 * i);
+            }
+        }
+        return v;
+    }
+    uint64_t u64() {
+        uint64_t v = 0;
+        if (has(8)) {
+            for (int i = 0; i < 8; ++i) {
+                v |= uint64_t(data[pos++]) << (8 * i);
+            }
+        }
+        return v;
+    }
+    uint64_t varint() {
+        uint64_t v = 0;
+        for (int shift = 0; shift < 64 && has(1); shift += 7) {
+            uint8_t byte = data[pos++];
+            v |= uint64_t(byte & 0x7F) << shift;
+            if (!(byte & 0x80)) {
+                return v;
+            }
+        }
+        ok = false;
+        return 0;
+    }
+    float f32() {
+        uint32_t bits = u32();
+        float v;
+        memcpy(&v, &bits, sizeof(v));
+        return v;
+    }
+    double f64() {
+        uint64_t bits = u64();
+        double v;
+        memcpy(&v, &bits, sizeof(v));
+        return v;
+    }
+};
@@ -0,0 +1,100 @@
+#pragma once
+
+#include <cmath>
+
+#include "sim.h"
+
+// ------------------------------------------------------
+// Player-vs-spike narrowphase: separating axis tests between the player's
+// square and a spike's triangle (shapes in sim.h). The candidate axes are
+// the box's x and y axes and the normals of the triangle's two slanted
+// edges (its base normal is the y axis). Written branch-free so the batch
+// kernels can vectorize them.
+// ------------------------------------------------------
+
+// Slanted edge normals, scaled to (-+simSpikeHeight, simSpikeHalfWidth).
+// On either one the triangle projects to +-simSpikeHeight*simSpikeHalfWidth
+// around its base centre and the player's square to +-collideEdgeRadius.
+const float collideEdgeExtent = simSpikeHeight * simSpikeHalfWidth;
+const float collideEdgeRadius = simPlayerHalfSize * (simSpikeHeight + simSpikeHalfWidth);
+
+// Does the triangle's projection [lo, hi] overlap the box's (-r, r)?
+inline bool collideAxis(float lo, float hi, float r) {
+    return (lo < r) & (hi > -r);
+}
+
+// Discrete test: do the shapes overlap at the end of the tick? px, py is
+// the spike's base centre relative to the player's centre.
+inline bool collideDiscreteAt(float px, float py) {
+    float left = -simSpikeHeight * px + simSpikeHalfWidth * py;
+    float right = simSpikeHeight * px + simSpikeHalfWidth * py;
+    return collideAxis(px - simSpikeHalfWidth, px + simSpikeHalfWidth, simPlayerHalfSize) &
+           collideAxis(py, py + simSpikeHeight, simPlayerHalfSize) &
+           collideAxis(left - collideEdgeExtent, left + collideEdgeExtent, collideEdgeRadius) &
+           collideAxis(right - collideEdgeExtent, right + collideEdgeExtent, collideEdgeRadius);
+}
+
+inline bool collideDiscrete(float spikeX, float spikeY, float playerY) {
+    return collideDiscreteAt(spikeX, spikeY - playerY);
+}
+
+// Does the range between p0 and p1 overlap (-h, h)? Every comparison is
+// made unconditionally, which keeps the batch kernels if-convertible.
+inline bool sweptSpans(float p0, float p1, float h) {
+    return ((p0 < h) | (p1 < h)) & ((p0 > -h) | (p1 > -h));
+}
+
+// Time window [enter, exit] (in ticks, unbounded) during which the
+// projection [lo + s t, hi + s t] overlaps (-r, r) on one axis
+inline void sweptAxis(float lo, float hi, float s, float r, float& enter, float& exit) {
+    const float never = 1e30f;
+    float inv = 1.0f / s; // inf or NaN results when s == 0 are discarded below
+    float tLo = (r - lo) * inv;  // lo + s t reaches r
+    float tHi = (-r - hi) * inv; // hi + s t reaches -r
+    float moving = s > 0.0f ? tHi : tLo;
+    float leaving = s > 0.0f ? tLo : tHi;
+    // Not moving along this axis: overlapping for all time or never
+    float stuck = collideAxis(lo, hi, r) ? never : -never;
+    enter = s != 0.0f ? moving : -stuck;
+    exit = s != 0.0f ? leaving : stuck;
+}
+
+// Swept test over one tick (moving SAT): the spike moves from x0 to x1
+// while the player moves from y0 to y1, both linearly. The shapes touch
+// during the tick if the overlap windows on all four axes intersect
+// within it. Catches spikes that pass through the player between ticks
+// (large steps, high scroll speeds), and is always at least as strict as
+// collideDiscrete() at the end of the tick.
+inline bool collideSwept(float x0, float x1, float spikeY, float y0, float y1) {
+    float py0 = spikeY - y0; // spike base relative to the player
+    float py1 = spikeY - y1;
+    float dx = x1 - x0;
+    float dy = py1 - py0;
+
+    float left0 = -simSpikeHeight * x0 + simSpikeHalfWidth * py0;
+    float right0 = simSpikeHeight * x0 + simSpikeHalfWidth * py0;
+    float leftSpeed = -simSpikeHeight * dx + simSpikeHalfWidth * dy;
+    float rightSpeed = simSpikeHeight * dx + simSpikeHalfWidth * dy;
+
+    float enterX, exitX, enterY, exitY, enterL, exitL, enterR, exitR;
+    sweptAxis(x0 - simSpikeHalfWidth, x0 + simSpikeHalfWidth, dx, simPlayerHalfSize, enterX, exitX);
+    sweptAxis(py0, py0 + simSpikeHeight, dy, simPlayerHalfSize, enterY, exitY);
+    sweptAxis(left0 - collideEdgeExtent, left0 + collideEdgeExtent, leftSpeed, collideEdgeRadius,
+              enterL, exitL);
+    sweptAxis(right0 - collideEdgeExtent, right0 + collideEdgeExtent, rightSpeed, collideEdgeRadius,
+              enterR, exitR);
+
+    float enter = enterX > enterY ? enterX : enterY;
+    enter = enter > enterL ? enter : enterL;
+    enter = enter > enterR ? enter : enterR;
+    enter = enter > 0.0f ? enter : 0.0f;
+    float exit = exitX < exitY ? exitX : exitY;
+    exit = exit < exitL ? exit : exitL;
+    exit = exit < exitR ? exit : exitR;
+    exit = exit < 1.0f ? exit : 1.0f;
+
+    // The sweep must also span the player's column; this keeps the test
+    // within the broad bounds exactly, whatever the rounding above
+    bool spansX = sweptSpans(x0, x1, simHitHalfWidth);
+    return collideDiscrete(x1, spikeY, y1) | (spansX & (enter < exit));
+}
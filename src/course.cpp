@@ -0,0 +1,133 @@
+#include "course.h"
+
+#include "course_file.h"
+
+// Extra distance before the first obstacle of a course
+static const uint32_t courseStartGap = 1200;
+
+// Random draws available to one chunk; a chunk makes at most three per obstacle
+static const uint64_t drawsPerChunk = 1024;
+
+uint64_t courseRandom(uint32_t seed, uint64_t counter) {
+    // SplitMix64 finalizer over the seed, then over the counter offset by it
+    auto mix = [](uint64_t z) {
+        z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+        z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+        return z ^ (z >> 31);
+    };
+    return mix(mix(uint64_t(seed) + 0x9E3779B97F4A7C15ull) + counter * 0x9E3779B97F4A7C15ull);
+}
+
+// The random draws of one chunk, in order
+struct ChunkRandom {
+    uint32_t seed;
+    uint64_t counter;
+
+    // Uniform in [0, n)
+    uint32_t below(uint32_t n) {
+        uint64_t bits = courseRandom(seed, counter++) >> 32;
+        return uint32_t((bits * n) >> 32);
+    }
+};
+
+// Obstacle patterns and their odds (out of 100)
+enum CoursePattern { PATTERN_SINGLE, PATTERN_DOUBLE, PATTERN_QUICK_PAIR, PATTERN_FLOATING,
+                     PATTERN_FLOATING_THEN_SPIKE };
+
+static CoursePattern pickPattern(uint32_t roll) {
+    static const uint32_t odds[] = {40, 20, 15, 15, 10};
+    uint32_t pattern = 0;
+    while (roll >= odds[pattern]) {
+        roll -= odds[pattern];
+        ++pattern;
+    }
+    return CoursePattern(pattern);
+}
+
+// ------------------------------------------------------
+// Build one chunk out of whole patterns. Every pattern starts a fresh gap
+// after the previous one, so chunks don't depend on each other; a pattern
+// that doesn't fit in the rest of the chunk becomes a single spike.
+// ------------------------------------------------------
+void courseGenerateChunk(uint32_t seed, uint64_t chunk, CourseObstacle* obstacles) {
+    ChunkRandom random = {seed, chunk * drawsPerChunk};
+    size_t count = 0;
+    while (count < courseChunkSize) {
+        uint32_t lead = 1000 + random.below(1601);
+        if (chunk == 0 && count == 0) {
+            lead += courseStartGap;
+        }
+        CoursePattern pattern = pickPattern(random.below(100));
+        if (pattern != PATTERN_SINGLE && pattern != PATTERN_FLOATING &&
+            count + 2 > courseChunkSize) {
+            pattern = PATTERN_SINGLE;
+        }
+
+        switch (pattern) {
+        case PATTERN_SINGLE:
+            obstacles[count++] = {lead, COURSE_SPIKE};
+            break;
+        case PATTERN_DOUBLE:
+            // Close enough to clear both in one jump
+            obstacles[count++] = {lead, COURSE_SPIKE};
+            obstacles[count++] = {courseMinGap + random.below(51), COURSE_SPIKE};
+            break;
+        case PATTERN_QUICK_PAIR:
+            // Far enough apart to land in between, with little time to spare
+            obstacles[count++] = {lead, COURSE_SPIKE};
+            obstacles[count++] = {900 + random.below(301), COURSE_SPIKE};
+            break;
+        case PATTERN_FLOATING:
+            obstacles[count++] = {lead, COURSE_FLOATING_SPIKE};
+            break;
+        case PATTERN_FLOATING_THEN_SPIKE:
+            // Stay down for the first, then jump straight away
+            obstacles[count++] = {lead, COURSE_FLOATING_SPIKE};
+            obstacles[count++] = {600 + random.below(301), COURSE_SPIKE};
+            break;
+        }
+    }
+}
+
+// Make sure chunk `chunk` is loaded; returns false if its bytes aren't
+// available yet, leaving the chunk reading as the end of the course
+static bool loadChunk(CourseCursor& cursor, const CourseSource& source, uint64_t chunk) {
+    if (cursor.chunkIds[chunk & 1] == chunk) {
+        return true;
+    }
+    CourseObstacle* obstacles = cursor.chunks[chunk & 1];
+    if (source.file) {
+        if (!source.file->readChunk(chunk, obstacles)) {
+            for (size_t i = 0; i < courseChunkSize; ++i) {
+                obstacles[i] = {courseEndGap, COURSE_SPIKE};
+            }
+            cursor.chunkIds[chunk & 1] = CourseCursor::noChunk;
+            return false;
+        }
+    } else {
+        courseGenerateChunk(source.seed, chunk, obstacles);
+    }
+    cursor.chunkIds[chunk & 1] = chunk;
+    return true;
+}
+
+void courseStart(CourseCursor& cursor, const CourseSource& source) {
+    courseSeek(cursor, source, 0);
+}
+
+void courseSeek(CourseCursor& cursor, const CourseSource& source, uint64_t next) {
+    cursor = CourseCursor();
+    cursor.next = next;
+    loadChunk(cursor, source, next / courseChunkSize);
+}
+
+void courseAdvance(CourseCursor& cursor, const CourseSource& source) {
+    ++cursor.next;
+    loadChunk(cursor, source, cursor.next / courseChunkSize);
+}
+
+bool coursePrefetch(CourseCursor& cursor, const CourseSource& source) {
+    uint64_t chunk = cursor.next / courseChunkSize;
+    bool current = loadChunk(cursor, source, chunk);
+    return loadChunk(cursor, source, chunk + 1) && current;
+}
@@ -0,0 +1,90 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+// ------------------------------------------------------
+// Obstacle courses.
+// A course is a sequence of obstacles laid out along the scrolling world,
+// each a gap after the previous one, handed out in chunks of
+// courseChunkSize obstacles. Designer courses are read from course files
+// (course_file.h). Otherwise the course is endless and generated by a
+// counter-based PRNG: chunk c is a pure function of (seed, c), so any
+// chunk can be built on its own, in any order, and the same seed gives the
+// same course on every platform (only integer math is involved). The
+// simulation keeps the chunk it is spawning from plus one chunk of
+// lookahead in a CourseCursor, so chunks are loaded once each, ideally
+// between ticks (coursePrefetch()).
+// ------------------------------------------------------
+
+// What an obstacle is
+enum CourseObstacleKind : uint8_t {
+    COURSE_SPIKE = 0,          // spike standing on the ground: jump over it
+    COURSE_FLOATING_SPIKE = 1, // spike just above a standing player: don't jump into it
+};
+
+// Distances along the course are whole course units of 1/1000 of a
+// screen unit (the x axis of the simulation)
+const float courseUnit = 0.001f;
+
+struct CourseObstacle {
+    uint32_t gap; // distance from the previous obstacle (or the course start), course units
+    uint8_t kind; // CourseObstacleKind
+};
+
+const size_t courseChunkSize = 32;
+
+// Gap of the obstacles past the end of a finite course: never reached
+const uint32_t courseEndGap = UINT32_MAX;
+
+// Smallest gap the generator produces between two obstacles; bounds how
+// many can be on screen at once.
+const uint32_t courseMinGap = 100;
+
+// Random bits for a (seed, counter) pair. Stateless: consecutive counters
+// give independent values.
+uint64_t courseRandom(uint32_t seed, uint64_t counter);
+
+// Generate chunk `chunk` of the course for `seed` (courseChunkSize obstacles).
+void courseGenerateChunk(uint32_t seed, uint64_t chunk, CourseObstacle* obstacles);
+
+class CourseFile;
+
+// Where a course's chunks come from
+struct CourseSource {
+    uint32_t seed = 0;               // generated from this seed...
+    const CourseFile* file = nullptr; // ...unless read from a course file
+};
+
+// Position in a course plus its loaded chunks. Plain data, so it is
+// copied along with the state it belongs to.
+struct CourseCursor {
+    static const uint64_t noChunk = UINT64_MAX;
+
+    uint64_t next = 0; // index of the next obstacle to spawn
+    uint64_t chunkIds[2] = {noChunk, noChunk}; // chunk c lives in chunks[c & 1]
+    CourseObstacle chunks[2][courseChunkSize] = {};
+};
+
+// Start at the beginning of a course, loading its first chunk.
+void courseStart(CourseCursor& cursor, const CourseSource& source);
+
+// Start at obstacle `next` of a course, loading its chunk.
+void courseSeek(CourseCursor& cursor, const CourseSource& source, uint64_t next);
+
+// The next obstacle. Its chunk is always loaded, except while a streamed
+// course file is still waiting for its bytes (see coursePrefetch()); it
+// then reads as courseEndGap.
+inline const CourseObstacle& courseNext(const CourseCursor& cursor) {
+    uint64_t chunk = cursor.next / courseChunkSize;
+    return cursor.chunks[chunk & 1][cursor.next % courseChunkSize];
+}
+
+// Move past the next obstacle, loading the following chunk if it wasn't
+// prefetched.
+void courseAdvance(CourseCursor& cursor, const CourseSource& source);
+
+// Load the chunk after the current one ahead of time (and the current one,
+// if it couldn't be loaded before). Returns true once both are loaded,
+// which only a streamed course file can delay.
+bool coursePrefetch(CourseCursor& cursor, const CourseSource& source);
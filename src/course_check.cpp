@@ -0,0 +1,212 @@
+#include "course_check.h"
+
+#include <cmath>
+
+#include "ballistics.h"
+
+// ------------------------------------------------------
+// Windows for one config
+// ------------------------------------------------------
+
+// Would a jump started on `takeoff` touch a spike of kind `kind` spawned
+// on `spawn`? Asked at the later of the two ticks, with the arc already
+// under way if the jump came first.
+static bool jumpTouches(const SimConfig& config, uint8_t kind, uint64_t spawn, uint64_t takeoff) {
+    SimState state;
+    state.tick = takeoff > spawn ? takeoff : spawn;
+    state.isOnGround = false;
+    state.launchY = config.groundY;
+    state.launchVelocity = config.jumpVelocity;
+    state.airTicks = uint32_t(state.tick - takeoff);
+    state.playerY = state.launchY + arcOffset(config, state.launchVelocity, state.airTicks);
+    Spike spike = {0.0f, simObstacleY(config, kind), spawn};
+    spike.x = simSpikeX(config, spike, state.tick);
+    state.spikes.push_back(spike);
+    simRehashSpikes(state);
+    uint64_t contact;
+    return firstSpikeContactTick(state, config, 0, contact);
+}
+
+// First tick a player standing still is touched by a spike of kind `kind`
+// spawned on `spawn` (UINT64_MAX if never)
+static uint64_t standingContact(const SimConfig& config, uint8_t kind, uint64_t spawn) {
+    SimState state;
+    state.tick = spawn;
+    state.playerY = state.launchY = config.groundY;
+    Spike spike = {simSpikeSpawnX, simObstacleY(config, kind), spawn};
+    state.spikes.push_back(spike);
+    simRehashSpikes(state);
+    uint64_t contact;
+    return firstSpikeContactTick(state, config, 0, contact) ? contact : UINT64_MAX;
+}
+
+bool courseJumpWindows(const SimConfig& config, CourseJumpWindows& windows) {
+    windows = CourseJumpWindows();
+    uint64_t landing = arcLandingTick(jumpArcAt(config, 0), config);
+    if (config.jumpVelocity <= 0.0f || landing == UINT64_MAX || landing > UINT32_MAX ||
+        simSpikeStep(config) <= 0.0f) {
+        return false;
+    }
+    windows.airTicks = int64_t(landing);
+
+    // Takeoffs from one flight before the spawn to the tick the spike has
+    // passed the player
+    const uint64_t spawn = landing;
+    const uint64_t passed = spawn + uint64_t(std::ceil((simSpikeSpawnX + simHitHalfWidth) /
+                                                       simSpikeStep(config))) + 2;
+
+    // Ground spikes: the longest run of takeoffs that clear the spike,
+    // before it reaches a player still standing
+    uint64_t hitStanding = standingContact(config, COURSE_SPIKE, spawn);
+    uint64_t last = hitStanding < passed ? hitStanding : passed;
+    uint64_t runFirst = 0;
+    uint64_t runLength = 0;
+    for (uint64_t k = spawn - landing + 1; k < last; ++k) {
+        if (jumpTouches(config, COURSE_SPIKE, spawn, k)) {
+            runLength = 0;
+            continue;
+        }
+        runFirst = runLength == 0 ? k : runFirst;
+        ++runLength;
+        if (runLength > uint64_t(windows.clearLast - windows.clearFirst + 1)) {
+            windows.clearFirst = int64_t(runFirst) - int64_t(spawn);
+            windows.clearLast = int64_t(k) - int64_t(spawn);
+        }
+    }
+
+    // Floating spikes: every takeoff that touches the spike
+    if (standingContact(config, COURSE_FLOATING_SPIKE, spawn) != UINT64_MAX) {
+        return false;
+    }
+    for (uint64_t k = spawn - landing + 1; k < passed; ++k) {
+        if (jumpTouches(config, COURSE_FLOATING_SPIKE, spawn, k)) {
+            int64_t offset = int64_t(k) - int64_t(spawn);
+            windows.hitFirst = windows.hitLast < windows.hitFirst ? offset : windows.hitFirst;
+            windows.hitLast = offset;
+        }
+    }
+    return windows.clearFirst <= windows.clearLast;
+}
+
+// ------------------------------------------------------
+// Interval arithmetic on takeoff ticks
+// ------------------------------------------------------
+
+// A set of ticks as sorted, disjoint, inclusive intervals. Capacity is
+// small; pieces beyond it are dropped, which only ever makes the check
+// stricter.
+struct TickSet {
+    static const size_t capacity = 16;
+    int64_t first[capacity];
+    int64_t last[capacity];
+    size_t count = 0;
+
+    bool empty() const { return count == 0; }
+
+    void add(int64_t lo, int64_t hi) {
+        if (lo > hi || count == capacity) {
+            return;
+        }
+        // Intervals are added in increasing order; merge touching ones
+        if (count > 0 && lo <= last[count - 1] + 1) {
+            last[count - 1] = hi > last[count - 1] ? hi : last[count - 1];
+            return;
+        }
+        first[count] = lo;
+        last[count] = hi;
+        ++count;
+    }
+
+    TickSet intersect(int64_t lo, int64_t hi) const {
+        TickSet out;
+        for (size_t i = 0; i < count; ++i) {
+            out.add(first[i] > lo ? first[i] : lo, last[i] < hi ? last[i] : hi);
+        }
+        return out;
+    }
+
+    TickSet subtract(int64_t lo, int64_t hi) const {
+        TickSet out;
+        for (size_t i = 0; i < count; ++i) {
+            out.add(first[i], last[i] < lo - 1 ? last[i] : lo - 1);
+            out.add(first[i] > hi + 1 ? first[i] : hi + 1, last[i]);
+        }
+        return out;
+    }
+
+    TickSet unite(const TickSet& other) const {
+        TickSet out;
+        size_t i = 0;
+        size_t j = 0;
+        while (i < count || j < other.count) {
+            if (j == other.count || (i < count && first[i] <= other.first[j])) {
+                out.add(first[i], last[i]);
+                ++i;
+            } else {
+                out.add(other.first[j], other.last[j]);
+                ++j;
+            }
+        }
+        return out;
+    }
+};
+
+// ------------------------------------------------------
+// Carry the set of possible latest takeoffs through the obstacles
+// ------------------------------------------------------
+size_t courseCheckObstacles(const SimConfig& config, const CourseJumpWindows& windows,
+                            const CourseObstacle* obstacles, size_t count) {
+    // Takeoff windows of the floating spikes that may still overlap a
+    // later ground spike's window
+    const size_t maxFloating = 16;
+    int64_t floatingFirst[maxFloating];
+    int64_t floatingLast[maxFloating];
+    size_t floatingCount = 0;
+
+    // Spawn ticks count from the obstacle before the first, which the
+    // player cleared by jumping as late as it allowed
+    int64_t spawn = 0;
+    TickSet latest;
+    latest.add(windows.clearLast, windows.clearLast);
+
+    for (size_t i = 0; i < count; ++i) {
+        spawn += simGapTicks(config, obstacles[i].gap);
+
+        if (obstacles[i].kind == COURSE_FLOATING_SPIKE) {
+            int64_t lo = spawn + windows.hitFirst;
+            int64_t hi = spawn + windows.hitLast;
+            latest = latest.subtract(lo, hi);
+            if (latest.empty() || floatingCount == maxFloating) {
+                return i;
+            }
+            floatingFirst[floatingCount] = lo;
+            floatingLast[floatingCount] = hi;
+            ++floatingCount;
+            continue;
+        }
+
+        // A ground spike is cleared by the latest jump if it started in
+        // the spike's window, or else by a new jump after that one lands
+        int64_t lo = spawn + windows.clearFirst;
+        int64_t hi = spawn + windows.clearLast;
+        int64_t landed = latest.first[0] + windows.airTicks;
+        TickSet fresh;
+        fresh.add(landed > lo ? landed : lo, hi);
+        size_t kept = 0;
+        for (size_t f = 0; f < floatingCount; ++f) {
+            fresh = fresh.subtract(floatingFirst[f], floatingLast[f]);
+            if (floatingLast[f] >= lo) {
+                floatingFirst[kept] = floatingFirst[f];
+                floatingLast[kept] = floatingLast[f];
+                ++kept;
+            }
+        }
+        floatingCount = kept;
+
+        latest = latest.intersect(lo, hi).unite(fresh);
+        if (latest.empty()) {
+            return i;
+        }
+    }
+    return count;
+}
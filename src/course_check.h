@@ -0,0 +1,43 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#include "course.h"
+#include "sim.h"
+
+// ------------------------------------------------------
+// Jumpability validator for courses.
+// For one config, a single obstacle constrains the tick a jump can start
+// on to a fixed window relative to the obstacle's spawn tick: a ground
+// spike is cleared only by a jump started inside its window, and a
+// floating spike hits any jump started inside its window. These windows
+// are found once per config with the exact predictions of ballistics.h.
+// Checking a run of obstacles is then interval arithmetic on takeoff
+// ticks: the set of ticks the latest jump can have started on is carried
+// from obstacle to obstacle (either the same jump also clears the next
+// spike, or a new one starts after landing), with no simulation.
+// ------------------------------------------------------
+
+struct CourseJumpWindows {
+    // Takeoff ticks, relative to a spike's spawn tick (Spike::spawnTick),
+    // of the jumps that clear a ground spike...
+    int64_t clearFirst = 0;
+    int64_t clearLast = -1;
+    // ...and of the jumps that hit a floating spike (a conservative hull)
+    int64_t hitFirst = 0;
+    int64_t hitLast = -1;
+    // Ticks from a takeoff to the first tick the player can jump again
+    int64_t airTicks = 0;
+};
+
+// Find the windows for `config`. Returns false if the player can't jump
+// (no gravity or no jump velocity) or a ground spike can't be cleared at all.
+bool courseJumpWindows(const SimConfig& config, CourseJumpWindows& windows);
+
+// Check that obstacles[0, count) can all be cleared, starting from a
+// player who jumped as late as possible for the obstacle before them.
+// Returns the index of the first obstacle that can't be cleared, or
+// count if every one can.
+size_t courseCheckObstacles(const SimConfig& config, const CourseJumpWindows& windows,
+                            const CourseObstacle* obstacles, size_t count);
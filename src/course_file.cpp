@@ -0,0 +1,287 @@
+#include "course_file.h"
+
+#include <cstdio>
+#include <cstring>
+
+#ifndef __EMSCRIPTEN__
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include "byte_io.h"
+
+// File layout (version 1), all values little-endian:
+//   "BGCS" magic, u32 version, u64 obstacleCount, u32 chunkCount, u64 indexOffset
+//   chunks: courseChunkSize obstacles each (the last may be short), every
+//           obstacle a varint of gap << 2 | kind
+//   index at indexOffset: chunkCount + 1 x u64 file offsets, of each chunk
+//           and finally of the index itself
+static const uint8_t courseMagic[4] = {'B', 'G', 'C', 'S'};
+static const uint32_t courseVersion = 1;
+static const unsigned kindBits = 2;
+
+CourseFile::~CourseFile() {
+    close();
+}
+
+bool CourseFile::parseHeader(const uint8_t* header, size_t size, uint64_t& indexOffset,
+                             uint32_t& chunks) {
+    if (size < courseFileHeaderSize || memcmp(header, courseMagic, 4) != 0) {
+        printf("Not a course file\n");
+        return false;
+    }
+    ByteReader in = {header, size, 4, true};
+    uint32_t version = in.u32();
+    if (version != courseVersion) {
+        printf("Unsupported course file version %u\n", version);
+        return false;
+    }
+    obstacles = in.u64();
+    chunks = in.u32();
+    indexOffset = in.u64();
+    if (obstacles > uint64_t(chunks) * courseChunkSize ||
+        (chunks > 0 && obstacles <= uint64_t(chunks - 1) * courseChunkSize)) {
+        printf("Corrupt course file header\n");
+        return false;
+    }
+    return in.ok;
+}
+
+bool CourseFile::parseIndex(const uint8_t* index, size_t size, uint32_t chunks,
+                            uint64_t indexOffset) {
+    // The index holds chunks + 1 offsets: check it can before allocating
+    // them, as the header's count is untrusted
+    if ((uint64_t(chunks) + 1) * 8 > size) {
+        printf("Corrupt course file index\n");
+        return false;
+    }
+    ByteReader in = {index, size, 0, true};
+    chunkOffsets.resize(size_t(chunks) + 1);
+    for (auto &offset : chunkOffsets) {
+        offset = in.u64();
+    }
+    bool ordered = in.ok && chunkOffsets.front() >= courseFileHeaderSize &&
+                   chunkOffsets.back() == indexOffset;
+    for (size_t i = 1; ordered && i < chunkOffsets.size(); ++i) {
+        ordered = chunkOffsets[i] >= chunkOffsets[i - 1];
+    }
+    if (!ordered) {
+        printf("Corrupt course file index\n");
+        chunkOffsets.clear();
+        return false;
+    }
+    return true;
+}
+
+bool CourseFile::map(const char* path) {
+    close();
+#ifdef __EMSCRIPTEN__
+    printf("Course files are streamed in the browser; can't map %s\n", path);
+    return false;
+#else
+    int fd = ::open(path, O_RDONLY);
+    if (fd < 0) {
+        printf("Cannot open %s\n", path);
+        return false;
+    }
+    struct stat info;
+    void* data = MAP_FAILED;
+    if (fstat(fd, &info) == 0 && info.st_size > 0) {
+        data = mmap(nullptr, size_t(info.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+    }
+    ::close(fd); // the mapping keeps the file alive
+    if (data == MAP_FAILED) {
+        printf("Cannot map %s\n", path);
+        return false;
+    }
+    mapped = static_cast<const uint8_t*>(data);
+    mappedSize = size_t(info.st_size);
+
+    uint64_t indexOffset;
+    uint32_t chunks;
+    if (!parseHeader(mapped, mappedSize, indexOffset, chunks) || indexOffset > mappedSize ||
+        !parseIndex(mapped + indexOffset, mappedSize - size_t(indexOffset), chunks, indexOffset)) {
+        close();
+        return false;
+    }
+    open = true;
+    return true;
+#endif
+}
+
+bool CourseFile::openStream(const uint8_t* header, size_t headerSize, const uint8_t* index,
+                            size_t indexSize) {
+    close();
+    uint64_t indexOffset;
+    uint32_t chunks;
+    if (!parseHeader(header, headerSize, indexOffset, chunks) ||
+        !parseIndex(index, indexSize, chunks, indexOffset)) {
+        return false;
+    }
+    open = true;
+    return true;
+}
+
+void CourseFile::close() {
+#ifndef __EMSCRIPTEN__
+    if (mapped) {
+        munmap(const_cast<uint8_t*>(mapped), mappedSize);
+    }
+#endif
+    mapped = nullptr;
+    mappedSize = 0;
+    open = false;
+    obstacles = 0;
+    chunkOffsets.clear();
+    for (auto &slot : streamed) {
+        slot.chunk = UINT64_MAX;
+        slot.bytes.clear();
+    }
+    nextSlot = 0;
+}
+
+bool CourseFile::hasChunk(uint64_t chunk) const {
+    if (mapped || chunk >= chunkCount()) {
+        return open;
+    }
+    for (const auto &slot : streamed) {
+        if (slot.chunk == chunk) {
+            return true;
+        }
+    }
+    return false;
+}
+
+void CourseFile::provideChunk(uint64_t chunk, const uint8_t* data, size_t size) {
+    if (!open || mapped || chunk >= chunkCount() || size != chunkSize(chunk) || hasChunk(chunk)) {
+        return;
+    }
+    StreamedChunk& slot = streamed[nextSlot];
+    nextSlot = (nextSlot + 1) % streamSlots;
+    slot.chunk = chunk;
+    slot.bytes.assign(data, data + size);
+}
+
+bool CourseFile::readChunk(uint64_t chunk, CourseObstacle* out) const {
+    if (!open) {
+        return false;
+    }
+    size_t count = 0;
+    if (chunk < chunkCount()) {
+        const uint8_t* bytes = nullptr;
+        if (mapped) {
+            bytes = mapped + chunkOffsets[chunk];
+        } else {
+            for (const auto &slot : streamed) {
+                if (slot.chunk == chunk) {
+                    bytes = slot.bytes.data();
+                }
+            }
+        }
+        if (!bytes) {
+            return false;
+        }
+
+        uint64_t first = chunk * courseChunkSize;
+        uint64_t left = obstacles - first;
+        count = left < courseChunkSize ? size_t(left) : courseChunkSize;
+        ByteReader in = {bytes, size_t(chunkSize(chunk)), 0, true};
+        bool known = true;
+        for (size_t i = 0; i < count; ++i) {
+            uint64_t v = in.varint();
+            uint64_t gap = v >> kindBits;
+            uint8_t kind = uint8_t(v & ((1u << kindBits) - 1));
+            known = known && kind <= COURSE_FLOATING_SPIKE;
+            if (in.ok && gap < courseMinGap) {
+                // Would crowd more spikes on screen than the state holds
+                printf("Course file obstacle %llu: gap %llu is below the minimum of %u\n",
+                       (unsigned long long)(first + i), (unsigned long long)gap, courseMinGap);
+                return false;
+            }
+            out[i].gap = gap < courseEndGap ? uint32_t(gap) : courseEndGap - 1;
+            out[i].kind = kind;
+        }
+        if (!in.ok || !known) {
+            printf("Corrupt course file chunk %llu\n", (unsigned long long)chunk);
+            return false;
+        }
+    }
+    for (size_t i = count; i < courseChunkSize; ++i) {
+        out[i] = {courseEndGap, COURSE_SPIKE};
+    }
+    return true;
+}
+
+bool courseFileIndexRange(const uint8_t* header, size_t size, uint64_t& offset, uint64_t& bytes) {
+    if (size < courseFileHeaderSize || memcmp(header, courseMagic, 4) != 0) {
+        return false;
+    }
+    ByteReader in = {header, size, 16, true};
+    uint32_t chunks = in.u32();
+    offset = in.u64();
+    bytes = (uint64_t(chunks) + 1) * 8;
+    return in.ok;
+}
+
+// ------------------------------------------------------
+// Writer: the header goes out first with a placeholder index offset,
+// then each chunk as it is encoded, then the index; finally the header is
+// rewritten with the real offset.
+// ------------------------------------------------------
+bool courseFileWrite(const char* path, const std::function<bool(CourseObstacle&)>& next) {
+    FILE* file = fopen(path, "wb");
+    if (!file) {
+        printf("Cannot open %s for writing\n", path);
+        return false;
+    }
+    uint64_t count = 0;
+    uint64_t chunks = 0;
+    auto writeHeader = [&](uint64_t indexOffset) {
+        std::vector<uint8_t> header(courseMagic, courseMagic + 4);
+        writeU32(header, courseVersion);
+        writeU64(header, count);
+        writeU32(header, uint32_t(chunks));
+        writeU64(header, indexOffset);
+        return fwrite(header.data(), 1, header.size(), file) == header.size();
+    };
+
+    bool ok = writeHeader(0);
+    std::vector<uint8_t> index;
+    std::vector<uint8_t> bytes;
+    uint64_t offset = courseFileHeaderSize;
+    bool more = true;
+    while (ok && more) {
+        bytes.clear();
+        size_t n = 0;
+        CourseObstacle obstacle;
+        while (n < courseChunkSize && (more = next(obstacle))) {
+            if (obstacle.gap < courseMinGap) {
+                printf("Obstacle %llu: gap %u is below the minimum of %u\n",
+                       (unsigned long long)(count + n), obstacle.gap, courseMinGap);
+                ok = false;
+                break;
+            }
+            writeVarint(bytes, uint64_t(obstacle.gap) << kindBits | obstacle.kind);
+            ++n;
+        }
+        if (!ok || n == 0) {
+            break;
+        }
+        writeU64(index, offset);
+        ok = fwrite(bytes.data(), 1, bytes.size(), file) == bytes.size();
+        offset += bytes.size();
+        count += n;
+        ++chunks;
+    }
+    writeU64(index, offset);
+    ok = ok && chunks <= UINT32_MAX;
+    ok = ok && fwrite(index.data(), 1, index.size(), file) == index.size();
+    ok = ok && fseek(file, 0, SEEK_SET) == 0 && writeHeader(offset);
+    ok = (fclose(file) == 0) && ok;
+    if (!ok) {
+        printf("Failed to write %s\n", path);
+    }
+    return ok;
+}
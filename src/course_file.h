@@ -0,0 +1,92 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+#include "course.h"
+
+// ------------------------------------------------------
+// Course files: designer-authored courses in a compact binary format.
+// Obstacles are stored as varints of their gap and kind (gaps are already
+// deltas), in chunks of courseChunkSize, with an index of chunk offsets so
+// any chunk can be found without reading the ones before it. A course is
+// never decoded as a whole: the simulation reads it chunk by chunk through
+// its CourseCursor. Natively the file is memory-mapped, so only the pages
+// of the chunks in use are read; in the browser the header and index are
+// fetched first and chunks are streamed in with HTTP range requests as
+// the game approaches them. Every gap is at least courseMinGap, which
+// bounds the spikes on screen by SimState::maxSpikes; files with smaller
+// gaps are refused when written and their chunks when read.
+// ------------------------------------------------------
+
+// Size of the fixed header at the start of a file
+const size_t courseFileHeaderSize = 28;
+
+class CourseFile {
+public:
+    CourseFile() = default;
+    ~CourseFile();
+    CourseFile(const CourseFile&) = delete;
+    CourseFile& operator=(const CourseFile&) = delete;
+
+    // Memory-map a course file (native builds only).
+    bool map(const char* path);
+
+    // Start streaming a course file: `header` holds its first
+    // courseFileHeaderSize bytes and `index` the indexSize() bytes at
+    // indexOffset(). Chunks are supplied later with provideChunk().
+    bool openStream(const uint8_t* header, size_t headerSize, const uint8_t* index,
+                    size_t indexSize);
+
+    void close();
+
+    bool isOpen() const { return open; }
+    uint64_t obstacleCount() const { return obstacles; }
+    uint64_t chunkCount() const { return chunkOffsets.empty() ? 0 : chunkOffsets.size() - 1; }
+
+    // Byte range of chunk `chunk` within the file
+    uint64_t chunkOffset(uint64_t chunk) const { return chunkOffsets[chunk]; }
+    uint64_t chunkSize(uint64_t chunk) const { return chunkOffsets[chunk + 1] - chunkOffsets[chunk]; }
+
+    // Streaming: whether a chunk's bytes are present, and handing them
+    // over. Only the last few chunks provided are kept.
+    bool hasChunk(uint64_t chunk) const;
+    void provideChunk(uint64_t chunk, const uint8_t* data, size_t size);
+
+    // Decode chunk `chunk`; obstacles past the end of the course get
+    // courseEndGap. Returns false if the chunk's bytes haven't been
+    // streamed in yet or don't decode.
+    bool readChunk(uint64_t chunk, CourseObstacle* out) const;
+
+private:
+    bool parseHeader(const uint8_t* header, size_t size, uint64_t& indexOffset, uint32_t& chunks);
+    bool parseIndex(const uint8_t* index, size_t size, uint32_t chunks, uint64_t indexOffset);
+
+    bool open = false;
+    uint64_t obstacles = 0;
+    std::vector<uint64_t> chunkOffsets; // chunkCount + 1 entries; the last is the index offset
+
+    // Mapped file (native)
+    const uint8_t* mapped = nullptr;
+    size_t mappedSize = 0;
+
+    // Streamed chunks, replaced oldest first
+    static const size_t streamSlots = 4;
+    struct StreamedChunk {
+        uint64_t chunk = UINT64_MAX;
+        std::vector<uint8_t> bytes;
+    };
+    StreamedChunk streamed[streamSlots];
+    size_t nextSlot = 0;
+};
+
+// Byte range of the chunk index, from a file's first courseFileHeaderSize
+// bytes. Returns false if they aren't a course file header.
+bool courseFileIndexRange(const uint8_t* header, size_t size, uint64_t& offset, uint64_t& bytes);
+
+// Write a course to `path`, asking `next` for its obstacles in order until
+// it returns false. The course is streamed out chunk by chunk, so it never
+// has to be held in memory. Fails on a gap below courseMinGap.
+bool courseFileWrite(const char* path, const std::function<bool(CourseObstacle&)>& next);
@@ -0,0 +1,93 @@
+#include "fast_forward.h"
+
+#include <cmath>
+
+#include "ballistics.h"
+#include "trace.h"
+
+// The player stands on the ground: each update is a resting arc that
+// lands immediately, leaving the state as it was.
+static bool isResting(const SimState& state, const SimConfig& config) {
+    return config.gravity < 0.0f && state.airTicks == 0 && state.launchVelocity == 0.0f &&
+           state.launchY == config.groundY && state.playerY == config.groundY;
+}
+
+// First tick at which the spike is culled (UINT64_MAX if it doesn't move)
+static uint64_t despawnTick(const SimConfig& config, const Spike& spike) {
+    if (!(simSpikeStep(config) > 0.0f)) {
+        return UINT64_MAX;
+    }
+    auto gone = [&](uint64_t k) { return simSpikeX(config, spike, k) < simSpikeDespawnX; };
+    double age = std::ceil((simSpikeSpawnX - simSpikeDespawnX) / simSpikeStep(config));
+    uint64_t k = spike.spawnTick + (age < 1.0 ? 1 : uint64_t(age));
+    while (k > spike.spawnTick + 1 && gone(k - 1)) {
+        --k;
+    }
+    while (!gone(k)) {
+        ++k;
+    }
+    return k;
+}
+
+// ------------------------------------------------------
+// Next tick whose update does more than follow the closed forms
+// ------------------------------------------------------
+uint64_t simNextEventTick(const SimState& state, const SimConfig& config) {
+    uint64_t next = state.tick + (simSpawnGapTicks(state, config) - state.ticksSinceSpawn);
+
+    if (!isResting(state, config)) {
+        uint64_t landing = arcLandingTick(currentArc(state), config);
+        next = landing < next ? landing : next;
+    }
+    if (!state.spikes.empty()) {
+        uint64_t despawn = despawnTick(config, state.spikes.front());
+        next = despawn < next ? despawn : next;
+    }
+    for (size_t i = 0; i < state.spikes.size(); ++i) {
+        uint64_t contact;
+        if (firstSpikeContactTick(state, config, i, contact) && contact < next) {
+            next = contact;
+        }
+    }
+    return next;
+}
+
+// Jump straight over `ticks` ticks in which no event happens
+static void skipQuietTicks(SimState& state, const SimConfig& config, uint64_t ticks) {
+    state.tick += ticks;
+    state.ticksSinceSpawn += uint32_t(ticks);
+    if (!isResting(state, config)) {
+        state.airTicks += uint32_t(ticks);
+        state.playerY = state.launchY + arcOffset(config, state.launchVelocity, state.airTicks);
+        state.playerVelocity = arcVelocity(config, state.launchVelocity, state.airTicks);
+    }
+    for (auto &spike : state.spikes) {
+        spike.x = simSpikeX(config, spike, state.tick);
+    }
+}
+
+// ------------------------------------------------------
+// Advance with no input, skipping to each event and stepping it normally.
+// The tick before each step is skipped to analytically; the step itself
+// then sets prevPlayerY as ticking would have.
+// ------------------------------------------------------
+uint64_t simFastForward(SimState& state, const SimConfig& config, uint64_t ticks,
+                        std::vector<uint64_t>* collisionTicks) {
+    TRACE_SCOPE("fast forward");
+    const uint64_t end = state.tick + ticks;
+    uint64_t collisions = 0;
+    while (state.tick < end) {
+        uint64_t next = simNextEventTick(state, config);
+        uint64_t target = next < end ? next : end;
+        if (target > state.tick + 1) {
+            skipQuietTicks(state, config, target - 1 - state.tick);
+        }
+        if (simUpdate(state, config, 0)) {
+            ++collisions;
+            if (collisionTicks) {
+                collisionTicks->push_back(state.tick - 1);
+            }
+        }
+    }
+    return collisions;
+}
@@ -0,0 +1,27 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "sim.h"
+
+// ------------------------------------------------------
+// Event-driven fast-forward.
+// With no input, everything between events follows a closed form: the
+// player's arc (ballistics.h), spike positions (simSpikeX()) and the
+// spawn counter. Only spawns, landings, despawns and collisions change the
+// state discontinuously, so idle stretches can be skipped in O(spikes)
+// instead of ticked through. Results are bit-identical to calling
+// simUpdate(state, config, 0) once per tick.
+// ------------------------------------------------------
+
+// Tick of the next event after state.tick when no input is given
+// (UINT64_MAX if nothing will ever happen).
+uint64_t simNextEventTick(const SimState& state, const SimConfig& config);
+
+// Advance `ticks` ticks with no input. If collisionTicks is given, the
+// index of every tick that ended in a collision (state.tick before that
+// update, as in replayRunFast()) is appended. Returns the number of
+// collisions.
+uint64_t simFastForward(SimState& state, const SimConfig& config, uint64_t ticks,
+                        std::vector<uint64_t>* collisionTicks = nullptr);
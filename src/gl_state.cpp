@@ -0,0 +1,193 @@
+#include "gl_state.h"
+
+#include <cstdint>
+#include <cstring>
+
+#include "gl_stats.h"
+
+static const GLuint unknownName = 0xFFFFFFFFu;
+static const int maxAttribs = 16;
+static const int maxUniforms = 64;
+
+// Vertex attribute setup of the default vertex array
+struct AttribState {
+    bool enabledKnown;
+    bool enabled;
+    bool divisorKnown;
+    GLuint divisor;
+    bool pointerKnown;
+    GLuint buffer;
+    GLint size;
+    GLenum type;
+    GLboolean normalized;
+    GLsizei stride;
+    const void* pointer;
+};
+
+// Last value uploaded to one uniform of one program
+struct UniformState {
+    GLuint program;
+    GLint location;
+    GLfloat value[4];
+};
+
+static GLuint currentProgram = unknownName;
+static GLuint arrayBuffer = unknownName;
+static GLuint elementBuffer = unknownName;
+static GLuint currentVAO = 0;
+static AttribState attribs[maxAttribs];
+static UniformState uniforms[maxUniforms];
+static int uniformCount = 0;
+
+void glCacheReset() {
+    currentProgram = unknownName;
+    arrayBuffer = unknownName;
+    elementBuffer = unknownName;
+    currentVAO = 0;
+    memset(attribs, 0, sizeof(attribs));
+    uniformCount = 0;
+}
+
+// ------------------------------------------------------
+// Bindings
+// ------------------------------------------------------
+void cachedUseProgram(GLuint program) {
+    if (program != currentProgram) {
+        currentProgram = program;
+        countedUseProgram(program);
+    }
+}
+
+void cachedBindBuffer(GLenum target, GLuint buffer) {
+    // The element array binding belongs to the bound VAO, so only the
+    // array buffer binding is global state.
+    GLuint* bound = target == GL_ARRAY_BUFFER ? &arrayBuffer
+                  : (target == GL_ELEMENT_ARRAY_BUFFER && currentVAO == 0) ? &elementBuffer
+                  : nullptr;
+    if (bound && *bound == buffer) {
+        return;
+    }
+    if (bound) {
+        *bound = buffer;
+    }
+    countedBindBuffer(target, buffer);
+}
+
+void cachedBindVertexArray(GLuint vao) {
+    if (vao != currentVAO) {
+        currentVAO = vao;
+        countedBindVertexArray(vao);
+    }
+}
+
+// ------------------------------------------------------
+// Vertex attributes
+// ------------------------------------------------------
+
+// Tracked state for index, or null when it can't be cached
+static AttribState* trackedAttrib(GLuint index) {
+    if (currentVAO != 0 || index >= GLuint(maxAttribs)) {
+        return nullptr;
+    }
+    return &attribs[index];
+}
+
+void cachedEnableVertexAttribArray(GLuint index) {
+    AttribState* a = trackedAttrib(index);
+    if (a && a->enabledKnown && a->enabled) {
+        return;
+    }
+    if (a) {
+        a->enabledKnown = true;
+        a->enabled = true;
+    }
+    countedEnableVertexAttribArray(index);
+}
+
+void cachedDisableVertexAttribArray(GLuint index) {
+    AttribState* a = trackedAttrib(index);
+    if (a && a->enabledKnown && !a->enabled) {
+        return;
+    }
+    if (a) {
+        a->enabledKnown = true;
+        a->enabled = false;
+    }
+    countedDisableVertexAttribArray(index);
+}
+
+void cachedVertexAttribPointer(GLuint index, GLint size, GLenum type, GLboolean normalized,
+                               GLsizei stride, const void* pointer) {
+    AttribState* a = trackedAttrib(index);
+    if (a && a->pointerKnown && a->buffer == arrayBuffer && a->size == size &&
+        a->type == type && a->normalized == normalized && a->stride == stride &&
+        a->pointer == pointer) {
+        return;
+    }
+    if (a) {
+        // An unknown array buffer binding means we can't tell what the
+        // pointer refers to, so don't remember it.
+        a->pointerKnown = arrayBuffer != unknownName;
+        a->buffer = arrayBuffer;
+        a->size = size;
+        a->type = type;
+        a->normalized = normalized;
+        a->stride = stride;
+        a->pointer = pointer;
+    }
+    countedVertexAttribPointer(index, size, type, normalized, stride, pointer);
+}
+
+void cachedVertexAttribDivisor(GLuint index, GLuint divisor) {
+    AttribState* a = trackedAttrib(index);
+    if (a && a->divisorKnown && a->divisor == divisor) {
+        return;
+    }
+    if (a) {
+        a->divisorKnown = true;
+        a->divisor = divisor;
+    }
+    countedVertexAttribDivisor(index, divisor);
+}
+
+// ------------------------------------------------------
+// Uniforms
+// ------------------------------------------------------
+
+// Returns true if the value differs from the last upload (and records it)
+static bool uniformChanged(GLint location, const GLfloat* value, int components) {
+    if (location < 0 || currentProgram == unknownName) {
+        return true;
+    }
+    for (int i = 0; i < uniformCount; ++i) {
+        UniformState& u = uniforms[i];
+        if (u.program == currentProgram && u.location == location) {
+            if (memcmp(u.value, value, components * sizeof(GLfloat)) == 0) {
+                return false;
+            }
+            memcpy(u.value, value, components * sizeof(GLfloat));
+            return true;
+        }
+    }
+    if (uniformCount < maxUniforms) {
+        UniformState& u = uniforms[uniformCount++];
+        u.program = currentProgram;
+        u.location = location;
+        memcpy(u.value, value, components * sizeof(GLfloat));
+    }
+    return true;
+}
+
+void cachedUniform2f(GLint location, GLfloat x, GLfloat y) {
+    GLfloat value[2] = {x, y};
+    if (uniformChanged(location, value, 2)) {
+        countedUniform2f(location, x, y);
+    }
+}
+
+void cachedUniform4f(GLint location, GLfloat x, GLfloat y, GLfloat z, GLfloat w) {
+    GLfloat value[4] = {x, y, z, w};
+    if (uniformChanged(location, value, 4)) {
+        countedUniform4f(location, x, y, z, w);
+    }
+}
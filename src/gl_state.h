@@ -0,0 +1,36 @@
+#pragma once
+
+#include <GLES3/gl3.h>
+
+// ------------------------------------------------------
+// Redundant GL state elision.
+// Every WebGL call crosses the wasm/JS boundary and is validated by the
+// browser, so the renderer sets state through these cached* functions,
+// which remember the current program, buffer bindings, VAO, vertex
+// attribute setup and last-uploaded uniform values, and skip calls that
+// would not change anything. Calls that do go through are issued via the
+// counted* wrappers, so GL_STATS builds report what actually reached GL.
+//
+// Any GL state changed behind the cache's back must be followed by
+// glCacheReset().
+// ------------------------------------------------------
+
+// Forget all tracked state; the next call of each kind is always issued.
+// Assumes the default vertex array is bound, as after context creation.
+void glCacheReset();
+
+void cachedUseProgram(GLuint program);
+void cachedBindBuffer(GLenum target, GLuint buffer);
+void cachedBindVertexArray(GLuint vao);
+
+// Attribute state is tracked for the default vertex array only; while a
+// VAO is bound these calls are recorded into it and always issued.
+void cachedEnableVertexAttribArray(GLuint index);
+void cachedDisableVertexAttribArray(GLuint index);
+void cachedVertexAttribPointer(GLuint index, GLint size, GLenum type, GLboolean normalized,
+                               GLsizei stride, const void* pointer);
+void cachedVertexAttribDivisor(GLuint index, GLuint divisor);
+
+// Uniform values are remembered per (program, location) for the current program.
+void cachedUniform2f(GLint location, GLfloat x, GLfloat y);
+void cachedUniform4f(GLint location, GLfloat x, GLfloat y, GLfloat z, GLfloat w);
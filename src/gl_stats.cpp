@@ -0,0 +1,75 @@
+#include "gl_stats.h"
+
+#ifdef GL_STATS
+
+#include <algorithm>
+#include <cstdio>
+
+GLFrameStats glStatsCurrent;
+
+// Rolling window of completed frames
+static GLFrameStats window[glStatsWindow];
+static int windowNext = 0;   // slot the next completed frame goes into
+static int windowCount = 0;
+
+static char jsonBuffer[2048];
+
+void glStatsEndFrame() {
+    window[windowNext] = glStatsCurrent;
+    windowNext = (windowNext + 1) % glStatsWindow;
+    if (windowCount < glStatsWindow) {
+        ++windowCount;
+    }
+    glStatsCurrent = GLFrameStats();
+}
+
+bool glStatsFrame(int age, GLFrameStats& out) {
+    if (age < 0 || age >= windowCount) {
+        return false;
+    }
+    out = window[(windowNext - 1 - age + glStatsWindow) % glStatsWindow];
+    return true;
+}
+
+// ------------------------------------------------------
+// JSON summary of the window
+// ------------------------------------------------------
+const char* glStatsJSON() {
+    struct Counter {
+        const char* name;
+        uint32_t GLFrameStats::*field;
+    };
+    static const Counter counters[] = {
+        {"glCalls", &GLFrameStats::glCalls},
+        {"drawCalls", &GLFrameStats::drawCalls},
+        {"vertices", &GLFrameStats::vertices},
+        {"bufferBinds", &GLFrameStats::bufferBinds},
+        {"vertexArrayBinds", &GLFrameStats::vertexArrayBinds},
+        {"bufferUploads", &GLFrameStats::bufferUploads},
+        {"uniformUploads", &GLFrameStats::uniformUploads},
+        {"programSwitches", &GLFrameStats::programSwitches},
+        {"attribCalls", &GLFrameStats::attribCalls},
+    };
+
+    GLFrameStats last;
+    glStatsFrame(0, last);
+
+    int len = snprintf(jsonBuffer, sizeof(jsonBuffer), "{\"frames\":%d", windowCount);
+    for (const auto &counter : counters) {
+        uint64_t sum = 0;
+        uint32_t max = 0;
+        for (int i = 0; i < windowCount; ++i) {
+            uint32_t value = window[i].*counter.field;
+            sum += value;
+            max = std::max(max, value);
+        }
+        double avg = windowCount > 0 ? double(sum) / windowCount : 0.0;
+        len += snprintf(jsonBuffer + len, sizeof(jsonBuffer) - len,
+                        ",\"%s\":{\"last\":%u,\"avg\":%.2f,\"max\":%u}",
+                        counter.name, last.*counter.field, avg, max);
+    }
+    snprintf(jsonBuffer + len, sizeof(jsonBuffer) - len, "}");
+    return jsonBuffer;
+}
+
+#endif
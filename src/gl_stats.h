@@ -0,0 +1,136 @@
+#pragma once
+
+#include <GLES3/gl3.h>
+#include <cstdint>
+
+// ------------------------------------------------------
+// Optional GL call instrumentation.
+// The renderer issues its GL calls through the counted* wrappers below.
+// When GL_STATS is defined (debug builds) every wrapper bumps a per-frame
+// counter; otherwise the wrappers are plain inline forwards and all of
+// the bookkeeping compiles away.
+// ------------------------------------------------------
+
+// GL work submitted during one frame
+struct GLFrameStats {
+    uint32_t glCalls = 0;         // every wrapped GL call
+    uint32_t drawCalls = 0;
+    uint32_t vertices = 0;        // vertices submitted, instances included
+    uint32_t bufferBinds = 0;
+    uint32_t vertexArrayBinds = 0;
+    uint32_t bufferUploads = 0;
+    uint32_t uniformUploads = 0;
+    uint32_t programSwitches = 0;
+    uint32_t attribCalls = 0;     // attribute enable/disable/pointer/divisor
+};
+
+#ifdef GL_STATS
+
+// Number of recent frames kept for the rolling window
+static const int glStatsWindow = 120;
+
+extern GLFrameStats glStatsCurrent;
+
+#define GL_STATS_ADD(field, n) (glStatsCurrent.field += (n))
+
+// Close the current frame: push it into the rolling window and start a new one.
+void glStatsEndFrame();
+
+// Stats of the frame `age` frames ago (0 = the last completed frame);
+// returns false if that frame is outside the window.
+bool glStatsFrame(int age, GLFrameStats& out);
+
+// Rolling-window summary as JSON: frame count plus last/avg/max per counter.
+// The returned string is valid until the next call.
+const char* glStatsJSON();
+
+#else
+
+#define GL_STATS_ADD(field, n) ((void)0)
+
+inline void glStatsEndFrame() {}
+
+#endif
+
+// ------------------------------------------------------
+// Counted GL wrappers
+// ------------------------------------------------------
+inline void countedClear(GLbitfield mask) {
+    GL_STATS_ADD(glCalls, 1);
+    glClear(mask);
+}
+
+inline void countedUseProgram(GLuint program) {
+    GL_STATS_ADD(glCalls, 1);
+    GL_STATS_ADD(programSwitches, 1);
+    glUseProgram(program);
+}
+
+inline void countedBindBuffer(GLenum target, GLuint buffer) {
+    GL_STATS_ADD(glCalls, 1);
+    GL_STATS_ADD(bufferBinds, 1);
+    glBindBuffer(target, buffer);
+}
+
+inline void countedBindVertexArray(GLuint vao) {
+    GL_STATS_ADD(glCalls, 1);
+    GL_STATS_ADD(vertexArrayBinds, 1);
+    glBindVertexArray(vao);
+}
+
+inline void countedBufferSubData(GLenum target, GLintptr offset, GLsizeiptr size, const void* data) {
+    GL_STATS_ADD(glCalls, 1);
+    GL_STATS_ADD(bufferUploads, 1);
+    glBufferSubData(target, offset, size, data);
+}
+
+inline void countedEnableVertexAttribArray(GLuint index) {
+    GL_STATS_ADD(glCalls, 1);
+    GL_STATS_ADD(attribCalls, 1);
+    glEnableVertexAttribArray(index);
+}
+
+inline void countedDisableVertexAttribArray(GLuint index) {
+    GL_STATS_ADD(glCalls, 1);
+    GL_STATS_ADD(attribCalls, 1);
+    glDisableVertexAttribArray(index);
+}
+
+inline void countedVertexAttribPointer(GLuint index, GLint size, GLenum type, GLboolean normalized,
+                                       GLsizei stride, const void* pointer) {
+    GL_STATS_ADD(glCalls, 1);
+    GL_STATS_ADD(attribCalls, 1);
+    glVertexAttribPointer(index, size, type, normalized, stride, pointer);
+}
+
+inline void countedVertexAttribDivisor(GLuint index, GLuint divisor) {
+    GL_STATS_ADD(glCalls, 1);
+    GL_STATS_ADD(attribCalls, 1);
+    glVertexAttribDivisor(index, divisor);
+}
+
+inline void countedUniform2f(GLint location, GLfloat x, GLfloat y) {
+    GL_STATS_ADD(glCalls, 1);
+    GL_STATS_ADD(uniformUploads, 1);
+    glUniform2f(location, x, y);
+}
+
+inline void countedUniform4f(GLint location, GLfloat x, GLfloat y, GLfloat z, GLfloat w) {
+    GL_STATS_ADD(glCalls, 1);
+    GL_STATS_ADD(uniformUploads, 1);
+    glUniform4f(location, x, y, z, w);
+}
+
+inline void countedDrawArrays(GLenum mode, GLint first, GLsizei count) {
+    GL_STATS_ADD(glCalls, 1);
+    GL_STATS_ADD(drawCalls, 1);
+    GL_STATS_ADD(vertices, uint32_t(count));
+    glDrawArrays(mode, first, count);
+}
+
+inline void countedDrawArraysInstanced(GLenum mode, GLint first, GLsizei count, GLsizei instances) {
+    GL_STATS_ADD(glCalls, 1);
+    GL_STATS_ADD(drawCalls, 1);
+    GL_STATS_ADD(vertices, uint32_t(count) * uint32_t(instances));
+    glDrawArraysInstanced(mode, first, count, instances);
+}
@@ -0,0 +1,132 @@
+#include "gym.h"
+
+#include <vector>
+
+#include "sim.h"
+
+struct GymEnvs {
+    uint32_t seed = 0;
+    size_t lookahead = 0;
+    uint32_t maxSteps = 0;
+    bool started = false; // gymReset() has been called
+
+    // Per environment: the config differs only in the seed, which the
+    // course keeps reading as it loads chunks
+    std::vector<SimConfig> configs;
+    std::vector<SimState> states;
+    std::vector<uint64_t> episodes; // episodes started, per environment
+    std::vector<uint32_t> steps;    // steps into the current episode
+
+    // Caller-owned outputs
+    float* observations = nullptr;
+    float* rewards = nullptr;
+    uint8_t* dones = nullptr;
+
+    size_t observationSize() const { return 3 + 2 * lookahead; }
+};
+
+// Start environment i's next episode on its own course
+static void beginEpisode(GymEnvs& envs, size_t i) {
+    envs.configs[i].seed = uint32_t(envs.seed + i + envs.episodes[i] * envs.states.size());
+    simInit(envs.states[i], envs.configs[i]);
+    ++envs.episodes[i];
+    envs.steps[i] = 0;
+}
+
+// ------------------------------------------------------
+// Write environment i's observation (layout in gym.h)
+// ------------------------------------------------------
+static void observe(const GymEnvs& envs, size_t i) {
+    const SimState& state = envs.states[i];
+    float groundY = envs.configs[i].groundY;
+    float* out = envs.observations + i * envs.observationSize();
+    out[0] = state.playerY - groundY;
+    out[1] = state.playerVelocity;
+    out[2] = state.isOnGround ? 1.0f : 0.0f;
+
+    // Spikes are ordered by x: skip the ones the player is past
+    size_t k = 0;
+    for (const auto &spike : state.spikes) {
+        if (k == envs.lookahead) {
+            break;
+        }
+        if (spike.x > -simHitHalfWidth) {
+            out[3 + 2 * k] = spike.x;
+            out[4 + 2 * k] = spike.y - groundY;
+            ++k;
+        }
+    }
+    for (; k < envs.lookahead; ++k) {
+        out[3 + 2 * k] = gymNoSpikeDistance;
+        out[4 + 2 * k] = 0.0f;
+    }
+}
+
+GymEnvs* gymCreate(int count, int lookahead, uint32_t maxSteps) {
+    if (count <= 0 || lookahead < 0 || size_t(lookahead) > SimState::maxSpikes) {
+        return nullptr;
+    }
+    GymEnvs* envs = new GymEnvs();
+    envs->lookahead = size_t(lookahead);
+    envs->maxSteps = maxSteps;
+    envs->configs.resize(size_t(count));
+    envs->states.resize(size_t(count));
+    envs->episodes.assign(size_t(count), 0);
+    envs->steps.assign(size_t(count), 0);
+    return envs;
+}
+
+void gymDestroy(GymEnvs* envs) {
+    delete envs;
+}
+
+int gymCount(const GymEnvs* envs) {
+    return int(envs->states.size());
+}
+
+int gymObservationSize(const GymEnvs* envs) {
+    return int(envs->observationSize());
+}
+
+void gymSetBuffers(GymEnvs* envs, float* observations, float* rewards, uint8_t* dones) {
+    envs->observations = observations;
+    envs->rewards = rewards;
+    envs->dones = dones;
+}
+
+int gymReset(GymEnvs* envs, uint32_t seed) {
+    if (!envs->observations) {
+        return -1;
+    }
+    envs->seed = seed;
+    envs->started = true;
+    for (size_t i = 0; i < envs->states.size(); ++i) {
+        envs->episodes[i] = 0;
+        beginEpisode(*envs, i);
+        observe(*envs, i);
+    }
+    return 0;
+}
+
+int gymStep(GymEnvs* envs, const uint8_t* actions) {
+    if (!envs->started || !envs->observations || !envs->rewards || !envs->dones) {
+        return -1;
+    }
+    int ended = 0;
+    for (size_t i = 0; i < envs->states.size(); ++i) {
+        uint32_t input = actions[i] ? SIM_INPUT_JUMP : 0;
+        bool collided = simUpdate(envs->states[i], envs->configs[i], input);
+        ++envs->steps[i];
+        uint8_t done = collided ? GYM_TERMINATED
+                       : (envs->maxSteps > 0 && envs->steps[i] >= envs->maxSteps) ? GYM_TRUNCATED
+                                                                                 : GYM_RUNNING;
+        envs->rewards[i] = collided ? 0.0f : 1.0f;
+        envs->dones[i] = done;
+        if (done != GYM_RUNNING) {
+            beginEpisode(*envs, i);
+            ++ended;
+        }
+        observe(*envs, i);
+    }
+    return ended;
+}
@@ -0,0 +1,77 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+// ------------------------------------------------------
+// Gym-style C API for training bots: a batch of independent games
+// stepped together, each one a SimState run by simUpdate() (sim.h), so
+// agents play exactly the game the browser runs. The action for an
+// environment is jump (non-zero) or not. Every step writes each
+// environment's observation, reward and done flag straight into buffers
+// the caller owns and registers once, e.g. numpy arrays, so nothing is
+// copied or allocated per step.
+//
+// An episode is one life: it ends when the player hits a spike, or is cut
+// short after maxSteps steps. Finished environments start their next
+// episode on a new course at once, and their observation is of that new
+// episode's first state. Every episode gets its own course: environment
+// i's n-th episode since the last gymReset() plays seed + i + n * count.
+//
+// Observation of one environment, gymObservationSize() floats:
+//   [0] player height above the ground
+//   [1] player vertical velocity, per 60 Hz frame like
+//       SimConfig::jumpVelocity (it doesn't scale with the tick rate)
+//   [2] 1 if standing on the ground, else 0
+//   then for each of the next `lookahead` spikes the player hasn't passed,
+//   nearest first:
+//   [3 + 2k] horizontal distance from the player
+//   [4 + 2k] height of its base above the ground (0 for ground spikes)
+//   Missing spikes read gymNoSpikeDistance and 0.
+// Reward: 1 for every step survived, 0 for the step that collided.
+// ------------------------------------------------------
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Distance reported for spike slots with no spike: past the right edge
+static const float gymNoSpikeDistance = 2.4f;
+
+// Why an environment's episode ended on a step
+enum GymDone {
+    GYM_RUNNING = 0,
+    GYM_TERMINATED = 1, // hit a spike
+    GYM_TRUNCATED = 2   // reached maxSteps
+};
+
+typedef struct GymEnvs GymEnvs;
+
+// `count` environments under the default config, observing `lookahead`
+// spikes ahead; maxSteps 0 never truncates. Returns null for a bad count
+// or lookahead (at most SimState::maxSpikes).
+GymEnvs* gymCreate(int count, int lookahead, uint32_t maxSteps);
+void gymDestroy(GymEnvs* envs);
+
+int gymCount(const GymEnvs* envs);
+int gymObservationSize(const GymEnvs* envs);
+
+// Register the output buffers: observations holds count *
+// gymObservationSize() floats, environment-major; rewards and dones hold
+// count entries each. They must stay valid until replaced.
+void gymSetBuffers(GymEnvs* envs, float* observations, float* rewards, uint8_t* dones);
+
+// Start every environment over from its first episode of the given seed
+// and write the observations. Call before the first step. Returns 0, or
+// -1 if no observation buffer is registered.
+int gymReset(GymEnvs* envs, uint32_t seed);
+
+// Apply one action per environment (count bytes) and advance every
+// environment one tick, writing observations, rewards and dones.
+// Returns the number of episodes that ended, or -1 if a buffer is missing
+// or the environments haven't been reset.
+int gymStep(GymEnvs* envs, const uint8_t* actions);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,27 @@
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+
+// ------------------------------------------------------
+// Small non-cryptographic hashing helpers shared by the state hashes and
+// the search bot's memo keys
+// ------------------------------------------------------
+
+// 64-bit finalizer (MurmurHash3's fmix64): every input bit affects every
+// output bit
+inline uint64_t hashMix(uint64_t h) {
+    h ^= h >> 33;
+    h *= 0xFF51AFD7ED558CCDull;
+    h ^= h >> 33;
+    h *= 0xC4CEB9FE1A85EC53ull;
+    h ^= h >> 33;
+    return h;
+}
+
+// Exact bits of a float, so -0.0 and 0.0 (or two NaNs) hash apart
+inline uint64_t hashFloatBits(float v) {
+    uint32_t bits;
+    memcpy(&bits, &v, sizeof(bits));
+    return bits;
+}
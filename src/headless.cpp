@@ -0,0 +1,2120 @@
+#include <dirent.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <condition_variable>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "ballistics.h"
+#include "collision.h"
+#include "course.h"
+#include "course_check.h"
+#include "course_file.h"
+#include "fast_forward.h"
+#include "gym.h"
+#include "replay.h"
+#include "rewind.h"
+#include "search_bot.h"
+#include "sim.h"
+#include "snapshot.h"
+#include "state_hash.h"
+#include "submission.h"
+#include "trace.h"
+#include "verifier.h"
+#include "work_pool.h"
+#include "world_batch.h"
+
+// ------------------------------------------------------
+// Native headless runner: drives the simulation without a browser,
+// window or GL context, for profiling, soak tests and bots.
+// ------------------------------------------------------
+
+static void printUsage() {
+    printf("usage: headless run [--ticks N] [--tick-rate HZ] [--seed N] [--course FILE] [--no-bot]\n");
+    printf("                    [--trace FILE] [--check-arcs] [--jump-every N] [--fast-forward]\n");
+    printf("       headless record --out FILE [--ticks N] [--tick-rate HZ] [--seed N] [--no-bot]\n");
+    printf("                       [--trace FILE] [--hashes] [--hash-interval N] [--keyframe N]\n");
+    printf("       headless replay FILE [--repeat N] [--quiet] [--trace FILE] [--stepped] [--verify]\n");
+    printf("                       [--seek N]\n");
+    printf("       headless compare FILE [OTHER]\n");
+    printf("       headless batch [--worlds N] [--ticks N] [--seed N] [--check N]\n");
+    printf("       headless collide-bench [--ticks N] [--tick-rate HZ] [--scroll-speed S] [--repeat N]\n");
+    printf("       headless course [--seed N] [--chunks N] [--list N] [--check] [--tick-rate HZ]\n");
+    printf("                       [--scroll-speed S]\n");
+    printf("       headless course-file --out FILE [--seed N] [--obstacles N] [--from TEXT] [--check]\n");
+    printf("       headless snapshot-bench [--ring N] [--count N] [--seed N]\n");
+    printf("       headless rewind [--ticks N] [--seconds S] [--keyframe N] [--seed N]\n");
+    printf("       headless verify (DIR | --listen PORT [--count N]) [--threads N] [--quiet]\n");
+    printf("       headless submit (--port PORT | --local) (DIR | --generate N [--ticks N] [--save DIR])\n");
+    printf("                       [--connections N] [--window N] [--cheat-every N] [--threads N]\n");
+    printf("       headless gym-bench [--envs N] [--steps N] [--lookahead K] [--threads N] [--seed N]\n");
+    printf("       headless search-bot [--games N] [--seconds S] [--horizon S] [--threads N] [--split]\n");
+    printf("                           [--check] [--seed N]\n");
+}
+
+static double secondsSince(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+static long fileSize(const char* path) {
+    FILE* file = fopen(path, "rb");
+    if (!file) {
+        return -1;
+    }
+    fseek(file, 0, SEEK_END);
+    long size = ftell(file);
+    fclose(file);
+    return size;
+}
+
+// ------------------------------------------------------
+// Read a whole file
+// ------------------------------------------------------
+static bool readFileBytes(const char* path, std::vector<uint8_t>& bytes) {
+    FILE* file = fopen(path, "rb");
+    if (!file) {
+        printf("Cannot open %s\n", path);
+        return false;
+    }
+    bytes.clear();
+    uint8_t buffer[4096];
+    size_t n;
+    while ((n = fread(buffer, 1, sizeof(buffer), file)) > 0) {
+        bytes.insert(bytes.end(), buffer, buffer + n);
+    }
+    fclose(file);
+    return true;
+}
+
+// ------------------------------------------------------
+// Write the recorded trace zones (the most recent ones) as Chrome JSON
+// ------------------------------------------------------
+static bool writeTrace(const char* path) {
+#ifdef TRACING
+    std::string json;
+    traceExportJSON(json);
+    FILE* file = fopen(path, "w");
+    if (!file) {
+        printf("Cannot open %s for writing\n", path);
+        return false;
+    }
+    fwrite(json.data(), 1, json.size(), file);
+    fclose(file);
+    printf("trace written to %s\n", path);
+    return true;
+#else
+    printf("Tracing is compiled out; rebuild with CXXFLAGS=-DTRACING to write %s\n", path);
+    return false;
+#endif
+}
+
+// ------------------------------------------------------
+// Minimal bot: jump when the nearest ground spike is about to reach the
+// player. Floating spikes pass over a player that stays down.
+// ------------------------------------------------------
+static bool botWantsJump(const SimState& state, const SimConfig& config) {
+    for (const auto &spike : state.spikes) {
+        if (spike.y == config.groundY && spike.x > 0.28f && spike.x < 0.36f) {
+            return true;
+        }
+    }
+    return false;
+}
+
+// ------------------------------------------------------
+// Bit-for-bit comparison of two simulation states
+// ------------------------------------------------------
+static bool sameBits(float a, float b) {
+    return memcmp(&a, &b, sizeof(float)) == 0;
+}
+
+static bool sameState(const SimState& a, const SimState& b) {
+    if (!sameBits(a.playerY, b.playerY) || !sameBits(a.playerVelocity, b.playerVelocity) ||
+        a.isOnGround != b.isOnGround || !sameBits(a.prevPlayerY, b.prevPlayerY) ||
+        !sameBits(a.launchY, b.launchY) || !sameBits(a.launchVelocity, b.launchVelocity) ||
+        a.airTicks != b.airTicks || a.ticksSinceSpawn != b.ticksSinceSpawn ||
+        a.course.next != b.course.next ||
+        a.tick != b.tick || a.spikes.size() != b.spikes.size()) {
+        return false;
+    }
+    for (size_t i = 0; i < a.spikes.size(); ++i) {
+        if (!sameBits(a.spikes[i].x, b.spikes[i].x) || !sameBits(a.spikes[i].y, b.spikes[i].y) ||
+            a.spikes[i].spawnTick != b.spikes[i].spawnTick) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// ------------------------------------------------------
+// Checks the closed-form predictions in ballistics.h against the stepped
+// simulation: every landing tick, and the first spike contact of each arc.
+// ------------------------------------------------------
+struct ArcChecker {
+    uint64_t predictedLanding = UINT64_MAX;
+    uint64_t predictedContact = UINT64_MAX;
+    uint64_t landings = 0;
+    uint64_t contacts = 0;
+    uint64_t airContacts = 0; // contacts during a jump, not standing
+    uint64_t mismatches = 0;
+
+    // Earliest predicted contact over all live spikes
+    static uint64_t nextContact(const SimState& state, const SimConfig& config) {
+        uint64_t first = UINT64_MAX;
+        for (size_t i = 0; i < state.spikes.size(); ++i) {
+            uint64_t tick;
+            if (firstSpikeContactTick(state, config, i, tick) && tick < first) {
+                first = tick;
+            }
+        }
+        return first;
+    }
+
+    // Call after each update; jumped = the input started a new arc.
+    void afterUpdate(const SimState& state, const SimConfig& config, bool wasOnGround,
+                     bool jumped, bool collided) {
+        if (!jumped) {
+            if (collided != (predictedContact == state.tick)) {
+                printf("tick %llu: contact predicted at %llu, collided=%d\n",
+                       (unsigned long long)state.tick, (unsigned long long)predictedContact,
+                       int(collided));
+                ++mismatches;
+            }
+            contacts += collided;
+            airContacts += collided && !wasOnGround;
+            if (!collided && !wasOnGround && state.isOnGround) {
+                if (predictedLanding != state.tick) {
+                    printf("tick %llu: landing predicted at %llu\n",
+                           (unsigned long long)state.tick, (unsigned long long)predictedLanding);
+                    ++mismatches;
+                }
+                ++landings;
+            }
+        }
+        // Predictions hold until the next input changes the arc. A player
+        // standing on the ground starts a new resting arc every tick.
+        if (jumped || collided || state.airTicks <= 1) {
+            predictedLanding = arcLandingTick(currentArc(state), config);
+            predictedContact = nextContact(state, config);
+        }
+    }
+};
+
+// ------------------------------------------------------
+// run / record: simulate a fixed number of ticks as fast as possible,
+// optionally recording the inputs to a replay file
+// ------------------------------------------------------
+static int runCommand(int argc, char** argv, bool record) {
+    SimConfig config;
+    uint64_t ticks = 10000000;
+    bool useBot = true;
+    const char* outPath = nullptr;
+    const char* tracePath = nullptr;
+    const char* coursePath = nullptr;
+    bool checkArcs = false;
+    bool fastForward = false;
+    uint64_t jumpEvery = 0;
+    uint32_t hashInterval = 0;
+    uint32_t keyframeInterval = replayKeyframeInterval;
+
+    for (int i = 0; i < argc; ++i) {
+        if (strcmp(argv[i], "--ticks") == 0 && i + 1 < argc) {
+            ticks = strtoull(argv[++i], nullptr, 10);
+        } else if (strcmp(argv[i], "--tick-rate") == 0 && i + 1 < argc) {
+            config.tickRate = atof(argv[++i]);
+        } else if (strcmp(argv[i], "--seed") == 0 && i + 1 < argc) {
+            config.seed = uint32_t(strtoul(argv[++i], nullptr, 10));
+        } else if (!record && strcmp(argv[i], "--course") == 0 && i + 1 < argc) {
+            coursePath = argv[++i];
+        } else if (strcmp(argv[i], "--no-bot") == 0) {
+            useBot = false;
+        } else if (record && strcmp(argv[i], "--out") == 0 && i + 1 < argc) {
+            outPath = argv[++i];
+        } else if (record && strcmp(argv[i], "--hashes") == 0) {
+            hashInterval = replayHashInterval;
+        } else if (record && strcmp(argv[i], "--hash-interval") == 0 && i + 1 < argc) {
+            hashInterval = uint32_t(strtoul(argv[++i], nullptr, 10));
+        } else if (record && strcmp(argv[i], "--keyframe") == 0 && i + 1 < argc) {
+            keyframeInterval = uint32_t(strtoul(argv[++i], nullptr, 10));
+        } else if (strcmp(argv[i], "--trace") == 0 && i + 1 < argc) {
+            tracePath = argv[++i];
+        } else if (strcmp(argv[i], "--check-arcs") == 0) {
+            checkArcs = true;
+        } else if (!record && strcmp(argv[i], "--jump-every") == 0 && i + 1 < argc) {
+            jumpEvery = strtoull(argv[++i], nullptr, 10);
+            useBot = false;
+        } else if (strcmp(argv[i], "--fast-forward") == 0) {
+            fastForward = true;
+        } else {
+            printUsage();
+            return 1;
+        }
+    }
+    if (config.tickRate <= 0.0) {
+        printf("Tick rate must be positive\n");
+        return 1;
+    }
+    if (record && (!outPath || keyframeInterval == 0)) {
+        printUsage();
+        return 1;
+    }
+    if (fastForward && (useBot || record || checkArcs || jumpEvery > 0)) {
+        printf("--fast-forward skips idle ticks, so it needs --no-bot and no per-tick options\n");
+        return 1;
+    }
+    CourseFile course;
+    if (coursePath) {
+        if (!course.map(coursePath)) {
+            return 1;
+        }
+        config.courseFile = &course;
+    }
+
+    SimState state;
+    simInit(state, config);
+    ReplayRecorder recorder;
+    if (record) {
+        recorder.begin(config, hashInterval);
+    }
+
+    ArcChecker checker;
+    uint64_t collisions = 0;
+    auto start = std::chrono::steady_clock::now();
+    if (fastForward) {
+        collisions = simFastForward(state, config, ticks);
+    } else {
+        for (uint64_t t = 0; t < ticks; ++t) {
+            // A fixed jump schedule lands some jumps and flies others into
+            // spikes; the bot is never hit, and without input nothing lands
+            bool jump = jumpEvery > 0 ? state.tick % jumpEvery == 0
+                                      : useBot && botWantsJump(state, config);
+            uint32_t input = jump ? SIM_INPUT_JUMP : 0;
+            if (record) {
+                recorder.recordTick(state.tick, input);
+            }
+            bool wasOnGround = state.isOnGround;
+            bool collided = simUpdate(state, config, input);
+            if (collided) {
+                ++collisions;
+            }
+            if (record) {
+                recorder.recordState(state);
+            }
+            if (checkArcs) {
+                bool jumped = (input & SIM_INPUT_JUMP) && wasOnGround;
+                checker.afterUpdate(state, config, wasOnGround, jumped, collided);
+            }
+        }
+    }
+    double seconds = secondsSince(start);
+
+    double gameSeconds = double(ticks) / config.tickRate;
+    printf("ticks:        %llu (%.1f s of game time)\n", (unsigned long long)ticks, gameSeconds);
+    printf("collisions:   %llu\n", (unsigned long long)collisions);
+    printf("wall time:    %.3f s\n", seconds);
+    printf("ticks/second: %.0f\n", seconds > 0.0 ? double(ticks) / seconds : 0.0);
+    if (checkArcs) {
+        printf("arc checks:   %llu landings, %llu contacts (%llu in the air), %llu mismatches\n",
+               (unsigned long long)checker.landings, (unsigned long long)checker.contacts,
+               (unsigned long long)checker.airContacts, (unsigned long long)checker.mismatches);
+        if (checker.mismatches > 0) {
+            return 1;
+        }
+        // The schedule is there to cover both predictions
+        if (jumpEvery > 0 && (checker.landings == 0 || checker.airContacts == 0)) {
+            printf("--jump-every %llu checked no %s; try another interval\n",
+                   (unsigned long long)jumpEvery,
+                   checker.landings == 0 ? "landings" : "contacts in the air");
+            return 1;
+        }
+    }
+
+    if (record) {
+        recorder.end();
+        Replay replay = recorder.replay();
+        replay.keyframeInterval = keyframeInterval;
+        if (!replayWriteFile(replay, outPath)) {
+            return 1;
+        }
+        long bytes = fileSize(outPath);
+        printf("recorded %zu input events to %s (%ld bytes, %.0f per hour of play)\n",
+               replay.events.size(), outPath, bytes, double(bytes) * 3600.0 / gameSeconds);
+    }
+    if (tracePath && !writeTrace(tracePath)) {
+        return 1;
+    }
+    return 0;
+}
+
+// ------------------------------------------------------
+// replay --seek: seek straight from the file's bytes to spread-out ticks,
+// checking each state against a stepped run, and compare the time with
+// re-running from tick 0
+// ------------------------------------------------------
+static bool seekBench(const char* path, const Replay& replay, uint64_t seeks) {
+    std::vector<uint8_t> bytes;
+    if (!readFileBytes(path, bytes)) {
+        return false;
+    }
+
+    // Ticks in increasing order, so one stepped run gives every reference
+    std::vector<uint64_t> ticks(static_cast<size_t>(seeks));
+    for (uint64_t i = 0; i < seeks; ++i) {
+        ticks[i] = (replay.tickCount * (2 * i + 1)) / (2 * seeks);
+    }
+    std::vector<SimStateHash> expected(ticks.size());
+    SimState state;
+    simInit(state, replay.config);
+    size_t nextEvent = 0;
+    for (size_t i = 0; i < ticks.size(); ++i) {
+        while (state.tick < ticks[i]) {
+            uint32_t input = 0;
+            if (nextEvent < replay.events.size() && replay.events[nextEvent].tick == state.tick) {
+                input = replay.events[nextEvent++].input;
+            }
+            simUpdate(state, replay.config, input);
+        }
+        simHashState(state, expected[i]);
+    }
+
+    uint64_t mismatches = 0;
+    SimConfig config;
+    SimStateHash hash;
+    auto start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < ticks.size(); ++i) {
+        if (!replaySeekSerialized(bytes.data(), bytes.size(), ticks[i], config, state)) {
+            ++mismatches;
+            continue;
+        }
+        simHashState(state, hash);
+        mismatches += hash != expected[i];
+    }
+    double seekSeconds = secondsSince(start);
+
+    // The same seeks without keyframes: from the start every time
+    Replay fromStart = replay;
+    fromStart.keyframes.clear();
+    start = std::chrono::steady_clock::now();
+    for (uint64_t tick : ticks) {
+        replaySeek(fromStart, tick, state);
+    }
+    double fromStartSeconds = secondsSince(start);
+
+    printf("seeks:        %llu, %llu mismatches, at most %u updates each\n",
+           (unsigned long long)seeks, (unsigned long long)mismatches, replay.keyframeInterval);
+    printf("seek time:    %.2f us from the file's index, %.2f us replaying from tick 0\n",
+           seekSeconds * 1e6 / double(seeks), fromStartSeconds * 1e6 / double(seeks));
+    return mismatches == 0;
+}
+
+// ------------------------------------------------------
+// replay: re-run a recorded replay as fast as possible, with no rendering
+// ------------------------------------------------------
+static int replayCommand(int argc, char** argv) {
+    const char* path = nullptr;
+    int repeat = 1;
+    bool quiet = false;
+    bool stepped = false;
+    bool verify = false;
+    uint64_t seeks = 0;
+    const char* tracePath = nullptr;
+
+    for (int i = 0; i < argc; ++i) {
+        if (strcmp(argv[i], "--repeat") == 0 && i + 1 < argc) {
+            repeat = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--seek") == 0 && i + 1 < argc) {
+            seeks = strtoull(argv[++i], nullptr, 10);
+        } else if (strcmp(argv[i], "--quiet") == 0) {
+            quiet = true;
+        } else if (strcmp(argv[i], "--stepped") == 0) {
+            stepped = true;
+        } else if (strcmp(argv[i], "--verify") == 0) {
+            verify = true;
+        } else if (strcmp(argv[i], "--trace") == 0 && i + 1 < argc) {
+            tracePath = argv[++i];
+        } else if (!path && argv[i][0] != '-') {
+            path = argv[i];
+        } else {
+            printUsage();
+            return 1;
+        }
+    }
+    if (!path || repeat < 1) {
+        printUsage();
+        return 1;
+    }
+
+    Replay replay;
+    if (!replayReadFile(path, replay)) {
+        return 1;
+    }
+    printf("replay:       %s (%llu ticks at %.1f Hz, %zu input events, seed %u)\n", path,
+           (unsigned long long)replay.tickCount, replay.config.tickRate,
+           replay.events.size(), replay.config.seed);
+
+    // Idle stretches are fast-forwarded unless --stepped asks for every tick
+    auto run = stepped ? replayRunStepped : replayRunFast;
+
+    SimState state;
+    std::vector<uint64_t> collisionTicks;
+    uint64_t collisions = run(replay, state, &collisionTicks);
+    if (!quiet) {
+        for (uint64_t tick : collisionTicks) {
+            printf("collision at tick %llu\n", (unsigned long long)tick);
+        }
+    }
+    printf("collisions:   %llu\n", (unsigned long long)collisions);
+    printf("final state:  tick %llu, playerY %.6f, velocity %.6f, %zu spikes\n",
+           (unsigned long long)state.tick, state.playerY, state.playerVelocity, state.spikes.size());
+
+    if (verify) {
+        // The other mode must reach exactly the same collisions and state
+        SimState other;
+        std::vector<uint64_t> otherTicks;
+        (stepped ? replayRunFast : replayRunStepped)(replay, other, &otherTicks);
+        if (otherTicks != collisionTicks || !sameState(state, other)) {
+            printf("Fast-forward and stepped runs differ!\n");
+            return 1;
+        }
+        printf("verified:     fast-forward and stepped runs are identical\n");
+    }
+    if (seeks > 0 && !seekBench(path, replay, seeks)) {
+        return 1;
+    }
+
+    // Benchmark: identical workload run after run
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < repeat; ++i) {
+        if (run(replay, state, nullptr) != collisions) {
+            printf("Replay diverged on repeat %d!\n", i);
+            return 1;
+        }
+    }
+    double seconds = secondsSince(start);
+    double totalTicks = double(replay.tickCount) * repeat;
+    printf("wall time:    %.3f s for %d run(s)\n", seconds, repeat);
+    printf("ticks/second: %.0f\n", seconds > 0.0 ? totalTicks / seconds : 0.0);
+    if (tracePath && !writeTrace(tracePath)) {
+        return 1;
+    }
+    return 0;
+}
+
+// ------------------------------------------------------
+// compare: find where runs of the same inputs diverge, between two of the
+// state hashes recorded with replays (or, without them, two keyframes),
+// and which fields differ at the keyframe after it. With one replay, it is
+// compared against this build's own stepped re-run; with two (say one
+// recorded in the browser and one natively), against each other, and this
+// build's re-run shows which of them it agrees with.
+// ------------------------------------------------------
+
+// A state field's value as text
+static void printStateField(const SimState& state, SimHashField field) {
+    switch (field) {
+    case SIM_HASH_PLAYER_Y: printf("%.9g", state.playerY); break;
+    case SIM_HASH_PLAYER_VELOCITY: printf("%.9g", state.playerVelocity); break;
+    case SIM_HASH_ON_GROUND: printf("%s", state.isOnGround ? "true" : "false"); break;
+    case SIM_HASH_PREV_PLAYER_Y: printf("%.9g", state.prevPlayerY); break;
+    case SIM_HASH_LAUNCH_Y: printf("%.9g", state.launchY); break;
+    case SIM_HASH_LAUNCH_VELOCITY: printf("%.9g", state.launchVelocity); break;
+    case SIM_HASH_AIR_TICKS: printf("%u", state.airTicks); break;
+    case SIM_HASH_COURSE: printf("%llu", (unsigned long long)state.course.next); break;
+    case SIM_HASH_TICKS_SINCE_SPAWN: printf("%u", state.ticksSinceSpawn); break;
+    case SIM_HASH_SPIKES:
+        printf("%zu spikes", state.spikes.size());
+        for (const auto &spike : state.spikes) {
+            printf(" (%.9g, %.9g, %llu)", spike.x, spike.y, (unsigned long long)spike.spawnTick);
+        }
+        break;
+    case SIM_HASH_TICK: printf("%llu", (unsigned long long)state.tick); break;
+    default: break;
+    }
+}
+
+static bool sameConfig(const SimConfig& a, const SimConfig& b) {
+    return a.tickRate == b.tickRate && sameBits(a.scrollSpeed, b.scrollSpeed) &&
+           sameBits(a.gravity, b.gravity) && sameBits(a.jumpVelocity, b.jumpVelocity) &&
+           sameBits(a.groundY, b.groundY) && a.seed == b.seed;
+}
+
+static int compareCommand(int argc, char** argv) {
+    const char* paths[2] = {nullptr, nullptr};
+    for (int i = 0; i < argc; ++i) {
+        if (!paths[0] && argv[i][0] != '-') {
+            paths[0] = argv[i];
+        } else if (!paths[1] && argv[i][0] != '-') {
+            paths[1] = argv[i];
+        } else {
+            printUsage();
+            return 1;
+        }
+    }
+    if (!paths[0]) {
+        printUsage();
+        return 1;
+    }
+    int files = paths[1] ? 2 : 1;
+    Replay replays[2];
+    for (int r = 0; r < files; ++r) {
+        if (!replayReadFile(paths[r], replays[r])) {
+            return 1;
+        }
+    }
+    const Replay& replay = replays[0];
+    if (files == 2) {
+        // Only the same inputs can be expected to give the same states
+        const Replay& other = replays[1];
+        bool sameEvents = replay.events.size() == other.events.size();
+        for (size_t i = 0; sameEvents && i < replay.events.size(); ++i) {
+            sameEvents = replay.events[i].tick == other.events[i].tick &&
+                         replay.events[i].input == other.events[i].input;
+        }
+        if (!sameConfig(replay.config, other.config) || !sameEvents) {
+            printf("The replays are of different runs (config or inputs differ)\n");
+            return 1;
+        }
+        if (replay.keyframeInterval != other.keyframeInterval) {
+            printf("The replays need the same keyframe interval\n");
+            return 1;
+        }
+    }
+    uint64_t ticks = replay.tickCount;
+    if (files == 2 && replays[1].tickCount < ticks) {
+        ticks = replays[1].tickCount;
+    }
+
+    // Hashes are compared if every file has them, at the same interval
+    uint32_t hashInterval = replay.hashes.empty() ? 0 : replay.hashInterval;
+    if (files == 2 && (replays[1].hashes.empty() || replays[1].hashInterval != hashInterval)) {
+        hashInterval = 0;
+    }
+    if (hashInterval > 0) {
+        printf("comparing state hashes every %u ticks and keyframes every %u ticks\n",
+               hashInterval, replay.keyframeInterval);
+    } else {
+        printf("no state hashes (record with --hashes for them); comparing keyframes every %u ticks\n",
+               replay.keyframeInterval);
+    }
+
+    // Re-run the inputs here, checking every hash and keyframe on the way.
+    // A hash only tells that the states differ; the fields that do are
+    // named at the next keyframe, which holds the whole state.
+    SimState state;
+    simInit(state, replay.config);
+    size_t nextEvent = 0;
+    uint64_t lastSame = 0;  // last tick whose state is known to agree
+    bool diverged = false;
+    for (uint64_t tick = 0; tick < ticks; ++tick) {
+        uint32_t input = 0;
+        if (nextEvent < replay.events.size() && replay.events[nextEvent].tick == tick) {
+            input = replay.events[nextEvent++].input;
+        }
+        simUpdate(state, replay.config, input);
+
+        if (!diverged && hashInterval > 0 && state.tick % hashInterval == 0) {
+            size_t index = size_t(state.tick / hashInterval - 1);
+            uint32_t local = replayStateHash(state);
+            uint32_t recorded[2] = {replay.hashes[index],
+                                    files == 2 ? replays[1].hashes[index] : local};
+            if (recorded[0] == recorded[1]) {
+                lastSame = state.tick;
+            } else {
+                diverged = true;
+                printf("diverged between ticks %llu and %llu (state hashes), of %llu\n",
+                       (unsigned long long)lastSame, (unsigned long long)state.tick,
+                       (unsigned long long)ticks);
+                if (files == 2) {
+                    printf("this build agrees with %s\n", local == recorded[0]   ? paths[0]
+                                                           : local == recorded[1] ? paths[1]
+                                                                                  : "neither");
+                }
+            }
+        }
+
+        uint64_t keyframe = state.tick / replay.keyframeInterval;
+        if (state.tick % replay.keyframeInterval != 0 || keyframe >= replay.keyframes.size()) {
+            continue;
+        }
+        SimStateHash local;
+        SimStateHash keyframes[2];
+        const SimStateHash* recorded[2] = {&keyframes[0], &local};
+        simHashState(state, local);
+        for (int r = 0; r < files; ++r) {
+            simHashState(replays[r].keyframes[keyframe].state, keyframes[r]);
+        }
+        recorded[1] = files == 2 ? &keyframes[1] : &local;
+        if (*recorded[0] == *recorded[1]) {
+            if (diverged) {
+                printf("the keyframe at tick %llu agrees again\n", (unsigned long long)state.tick);
+                return 1;
+            }
+            lastSame = state.tick;
+            continue;
+        }
+
+        if (!diverged) {
+            printf("diverged between ticks %llu and %llu (keyframes), of %llu\n",
+                   (unsigned long long)lastSame, (unsigned long long)state.tick,
+                   (unsigned long long)ticks);
+        }
+        printf("fields that differ at the keyframe at tick %llu:\n", (unsigned long long)state.tick);
+        printf("%-16s %-10s %s\n", "field", files == 2 ? "first" : "recorded",
+               files == 2 ? "second" : "this build");
+        for (int f = 0; f < SIM_HASH_FIELD_COUNT; ++f) {
+            if (recorded[0]->fields[f] != recorded[1]->fields[f]) {
+                printf("%-16s %08x   %08x\n", simHashFieldNames[f], recorded[0]->fields[f],
+                       recorded[1]->fields[f]);
+            }
+        }
+        if (files == 2 && !diverged) {
+            bool matchesFirst = local == *recorded[0];
+            bool matchesSecond = local == *recorded[1];
+            printf("this build agrees with %s\n", matchesFirst ? paths[0]
+                                                   : matchesSecond ? paths[1]
+                                                                   : "neither");
+        }
+        printf("this build's values at the keyframe:\n");
+        for (int f = 0; f < SIM_HASH_FIELD_COUNT; ++f) {
+            if (recorded[0]->fields[f] != recorded[1]->fields[f] ||
+                (files == 2 && local.fields[f] != recorded[0]->fields[f])) {
+                printf("  %s = ", simHashFieldNames[f]);
+                printStateField(state, SimHashField(f));
+                printf("\n");
+            }
+        }
+        return 1;
+    }
+    if (diverged) {
+        printf("no keyframe after it to name the fields that differ\n");
+        return 1;
+    }
+    SimStateHash final;
+    simHashState(state, final);
+    printf("identical:    %llu ticks, final hash %016llx\n", (unsigned long long)ticks,
+           (unsigned long long)final.combined());
+    return 0;
+}
+
+// ------------------------------------------------------
+// batch: step many worlds at once with the SoA kernel and report
+// throughput in worlds*ticks per second
+// ------------------------------------------------------
+
+// Deterministic pseudo-random inputs so every world plays differently
+static uint8_t batchInput(uint64_t world, uint64_t tick) {
+    uint64_t h = (world * 0x9E3779B97F4A7C15ull) ^ (tick * 0xC2B2AE3D27D4EB4Full);
+    h ^= h >> 29;
+    h *= 0xBF58476D1CE4E5B9ull;
+    h ^= h >> 32;
+    return (h & 31) == 0 ? SIM_INPUT_JUMP : 0;
+}
+
+static int batchCommand(int argc, char** argv) {
+    SimConfig config;
+    size_t worlds = 4096;
+    uint64_t ticks = 10000;
+    size_t check = 0;
+
+    for (int i = 0; i < argc; ++i) {
+        if (strcmp(argv[i], "--worlds") == 0 && i + 1 < argc) {
+            worlds = strtoull(argv[++i], nullptr, 10);
+        } else if (strcmp(argv[i], "--ticks") == 0 && i + 1 < argc) {
+            ticks = strtoull(argv[++i], nullptr, 10);
+        } else if (strcmp(argv[i], "--seed") == 0 && i + 1 < argc) {
+            config.seed = uint32_t(strtoul(argv[++i], nullptr, 10));
+        } else if (strcmp(argv[i], "--check") == 0 && i + 1 < argc) {
+            check = strtoull(argv[++i], nullptr, 10);
+        } else {
+            printUsage();
+            return 1;
+        }
+    }
+    if (worlds == 0 || check > worlds) {
+        printUsage();
+        return 1;
+    }
+
+    WorldBatch batch;
+    batch.init(worlds, config);
+    std::vector<uint8_t> inputs(worlds);
+    std::vector<uint8_t> collided(worlds);
+
+    // Optionally run the first `check` worlds through the scalar simulation
+    // alongside the batch and compare them bit for bit every tick.
+    std::vector<SimState> reference(check);
+    for (auto &state : reference) {
+        simInit(state, config);
+    }
+
+    uint64_t collisions = 0;
+    double stepSeconds = 0.0;
+    for (uint64_t t = 0; t < ticks; ++t) {
+        for (size_t w = 0; w < worlds; ++w) {
+            inputs[w] = batchInput(w, t);
+        }
+
+        auto start = std::chrono::steady_clock::now();
+        batch.step(inputs.data(), collided.data());
+        stepSeconds += secondsSince(start);
+
+        for (size_t w = 0; w < worlds; ++w) {
+            collisions += collided[w];
+        }
+        for (size_t w = 0; w < check; ++w) {
+            bool hit = simUpdate(reference[w], config, inputs[w]);
+            if (hit != (collided[w] != 0) ||
+                memcmp(&reference[w].playerY, &batch.playerY()[w], sizeof(float)) != 0 ||
+                memcmp(&reference[w].playerVelocity, &batch.playerVelocity()[w], sizeof(float)) != 0) {
+                printf("World %zu diverged from the scalar simulation at tick %llu\n",
+                       w, (unsigned long long)t);
+                return 1;
+            }
+        }
+    }
+
+    double worldTicks = double(worlds) * double(ticks);
+    printf("worlds:             %zu (%zu spike slots)\n", worlds, batch.spikeSlotCount());
+    printf("ticks:              %llu\n", (unsigned long long)ticks);
+    printf("collisions:         %llu\n", (unsigned long long)collisions);
+    if (check > 0) {
+        printf("scalar check:       %zu worlds identical\n", check);
+    }
+    printf("step time:          %.3f s\n", stepSeconds);
+    printf("worlds*ticks/second: %.0f\n", stepSeconds > 0.0 ? worldTicks / stepSeconds : 0.0);
+    return 0;
+}
+
+// ------------------------------------------------------
+// collide-bench: cost of the discrete and swept narrowphase tests, on
+// every player/spike pair of a real run, and the hits each one finds
+// ------------------------------------------------------
+static int collideBenchCommand(int argc, char** argv) {
+    SimConfig config;
+    uint64_t ticks = 1000000;
+    int repeat = 20;
+
+    for (int i = 0; i < argc; ++i) {
+        if (strcmp(argv[i], "--ticks") == 0 && i + 1 < argc) {
+            ticks = strtoull(argv[++i], nullptr, 10);
+        } else if (strcmp(argv[i], "--tick-rate") == 0 && i + 1 < argc) {
+            config.tickRate = atof(argv[++i]);
+        } else if (strcmp(argv[i], "--scroll-speed") == 0 && i + 1 < argc) {
+            config.scrollSpeed = float(atof(argv[++i]));
+        } else if (strcmp(argv[i], "--repeat") == 0 && i + 1 < argc) {
+            repeat = atoi(argv[++i]);
+        } else {
+            printUsage();
+            return 1;
+        }
+    }
+    if (config.tickRate <= 0.0 || !(config.scrollSpeed > 0.0f) || repeat < 1) {
+        printUsage();
+        return 1;
+    }
+
+    // Every spike's motion over every tick, with random jumps so the
+    // player is at all heights (structure-of-arrays, like WorldBatch).
+    // Taken before each update, so the pairs that collide are included.
+    std::vector<float> x0s, x1s, spikeYs, y0s, y1s;
+    SimState state;
+    simInit(state, config);
+    for (uint64_t t = 0; t < ticks; ++t) {
+        uint32_t input = batchInput(0, t);
+        bool jumps = (input & SIM_INPUT_JUMP) && state.isOnGround;
+        JumpArc arc = jumps ? JumpArc{state.tick, state.playerY, config.jumpVelocity} : currentArc(state);
+        float nextY = arcHeight(arc, config, state.tick + 1);
+        for (const auto &spike : state.spikes) {
+            x0s.push_back(spike.x);
+            x1s.push_back(simSpikeX(config, spike, state.tick + 1));
+            spikeYs.push_back(spike.y);
+            y0s.push_back(state.playerY);
+            y1s.push_back(nextY);
+        }
+        simUpdate(state, config, input);
+    }
+    const size_t pairs = x0s.size();
+    size_t inReach = 0;
+    for (size_t i = 0; i < pairs; ++i) {
+        inReach += sweptSpans(x0s[i], x1s[i], simHitHalfWidth);
+    }
+
+    uint64_t discreteHits = 0;
+    auto start = std::chrono::steady_clock::now();
+    for (int r = 0; r < repeat; ++r) {
+        discreteHits = 0;
+        for (size_t i = 0; i < pairs; ++i) {
+            discreteHits += collideDiscrete(x1s[i], spikeYs[i], y1s[i]);
+        }
+    }
+    double discreteSeconds = secondsSince(start);
+
+    uint64_t sweptHits = 0;
+    start = std::chrono::steady_clock::now();
+    for (int r = 0; r < repeat; ++r) {
+        sweptHits = 0;
+        for (size_t i = 0; i < pairs; ++i) {
+            sweptHits += collideSwept(x0s[i], x1s[i], spikeYs[i], y0s[i], y1s[i]);
+        }
+    }
+    double sweptSeconds = secondsSince(start);
+
+    double tests = double(pairs) * repeat;
+    printf("spike step:   %.4f per tick (hit width %.2f)\n", simSpikeStep(config), 2.0f * simHitHalfWidth);
+    printf("pairs tested: %zu (%zu past the broadphase)\n", pairs, inReach);
+    printf("discrete:     %llu hits, %.2f ns/test\n", (unsigned long long)discreteHits,
+           tests > 0.0 ? discreteSeconds * 1e9 / tests : 0.0);
+    printf("swept:        %llu hits, %.2f ns/test\n", (unsigned long long)sweptHits,
+           tests > 0.0 ? sweptSeconds * 1e9 / tests : 0.0);
+    printf("tunneled:     %llu hits missed by the discrete test\n",
+           (unsigned long long)(sweptHits - discreteHits));
+    return 0;
+}
+
+// ------------------------------------------------------
+// course: list the start of a seed's course, checksum the first chunks
+// (compare against the wasm build to confirm they match) and report the
+// generation rate. --check also validates that every chunk can be
+// cleared with the config's jump (course_check.h), and the validation rate.
+// ------------------------------------------------------
+static int courseCommand(int argc, char** argv) {
+    SimConfig config;
+    uint32_t seed = 0;
+    uint64_t chunks = 100000;
+    uint64_t list = 16;
+    bool check = false;
+
+    for (int i = 0; i < argc; ++i) {
+        if (strcmp(argv[i], "--seed") == 0 && i + 1 < argc) {
+            seed = uint32_t(strtoul(argv[++i], nullptr, 10));
+        } else if (strcmp(argv[i], "--chunks") == 0 && i + 1 < argc) {
+            chunks = strtoull(argv[++i], nullptr, 10);
+        } else if (strcmp(argv[i], "--list") == 0 && i + 1 < argc) {
+            list = strtoull(argv[++i], nullptr, 10);
+        } else if (strcmp(argv[i], "--check") == 0) {
+            check = true;
+        } else if (strcmp(argv[i], "--tick-rate") == 0 && i + 1 < argc) {
+            config.tickRate = atof(argv[++i]);
+        } else if (strcmp(argv[i], "--scroll-speed") == 0 && i + 1 < argc) {
+            config.scrollSpeed = float(atof(argv[++i]));
+        } else {
+            printUsage();
+            return 1;
+        }
+    }
+
+    CourseObstacle obstacles[courseChunkSize];
+    uint64_t position = 0;
+    for (uint64_t c = 0; c * courseChunkSize < list; ++c) {
+        courseGenerateChunk(seed, c, obstacles);
+        for (size_t i = 0; i < courseChunkSize && c * courseChunkSize + i < list; ++i) {
+            position += obstacles[i].gap;
+            printf("%6llu: %8.3f %s\n", (unsigned long long)(c * courseChunkSize + i),
+                   double(position) * courseUnit,
+                   obstacles[i].kind == COURSE_FLOATING_SPIKE ? "floating spike" : "spike");
+        }
+    }
+
+    // FNV-1a over every obstacle
+    uint64_t checksum = 0xCBF29CE484222325ull;
+    auto start = std::chrono::steady_clock::now();
+    for (uint64_t c = 0; c < chunks; ++c) {
+        courseGenerateChunk(seed, c, obstacles);
+        for (const auto &obstacle : obstacles) {
+            checksum = (checksum ^ (obstacle.gap | uint64_t(obstacle.kind) << 32)) * 0x100000001B3ull;
+        }
+    }
+    double seconds = secondsSince(start);
+
+    printf("seed:         %u\n", seed);
+    printf("chunks:       %llu (%llu obstacles)\n", (unsigned long long)chunks,
+           (unsigned long long)(chunks * courseChunkSize));
+    printf("checksum:     %016llx\n", (unsigned long long)checksum);
+    printf("chunks/second: %.0f\n", seconds > 0.0 ? double(chunks) / seconds : 0.0);
+    if (!check) {
+        return 0;
+    }
+
+    if (config.tickRate <= 0.0 || !(config.scrollSpeed > 0.0f)) {
+        printUsage();
+        return 1;
+    }
+    CourseJumpWindows windows;
+    start = std::chrono::steady_clock::now();
+    bool jumpable = courseJumpWindows(config, windows);
+    double windowSeconds = secondsSince(start);
+    if (!jumpable) {
+        printf("No jump clears a ground spike at this tick rate and scroll speed\n");
+        return 1;
+    }
+
+    // Chunks are generated up front so only the validation is timed
+    std::vector<CourseObstacle> course(chunks * courseChunkSize);
+    for (uint64_t c = 0; c < chunks; ++c) {
+        courseGenerateChunk(seed, c, &course[c * courseChunkSize]);
+    }
+    uint64_t failed = 0;
+    start = std::chrono::steady_clock::now();
+    for (uint64_t c = 0; c < chunks; ++c) {
+        const CourseObstacle* chunk = &course[c * courseChunkSize];
+        size_t cleared = courseCheckObstacles(config, windows, chunk, courseChunkSize);
+        if (cleared < courseChunkSize) {
+            if (failed < 10) {
+                printf("chunk %llu: obstacle %zu can't be cleared\n", (unsigned long long)c, cleared);
+            }
+            ++failed;
+        }
+    }
+    seconds = secondsSince(start);
+
+    printf("jump windows: clear ground spikes from %lld to %lld ticks after spawn, floating\n"
+           "              spikes hit from %lld to %lld, %lld ticks in the air (%.3f ms to find)\n",
+           (long long)windows.clearFirst, (long long)windows.clearLast,
+           (long long)windows.hitFirst, (long long)windows.hitLast, (long long)windows.airTicks,
+           windowSeconds * 1e3);
+    printf("unclearable:  %llu of %llu chunks\n", (unsigned long long)failed,
+           (unsigned long long)chunks);
+    printf("chunks validated/second: %.0f\n", seconds > 0.0 ? double(chunks) / seconds : 0.0);
+    return failed > 0 ? 1 : 0;
+}
+
+// ------------------------------------------------------
+// course-file: write a course file, from a seed's generated course or a
+// designer's text listing (one "<position> spike|floating" line per
+// obstacle, positions in screen units as printed by `course --list`, #
+// starts a comment). The file is then mapped back and decoded chunk by
+// chunk to check it round-trips, with the time to open it and the decode
+// rate. --check also validates it can be cleared (course_check.h).
+// ------------------------------------------------------
+
+// Read the next obstacle from a text listing; false at the end or on an
+// error (`error` is set then)
+static bool readTextObstacle(FILE* file, uint64_t& line, uint64_t& position,
+                             CourseObstacle& obstacle, bool& error) {
+    char text[256];
+    while (fgets(text, sizeof(text), file)) {
+        ++line;
+        char* comment = strchr(text, '#');
+        if (comment) {
+            *comment = '\0';
+        }
+        double at;
+        char kind[32];
+        int fields = sscanf(text, "%lf %31s", &at, kind);
+        if (fields <= 0) {
+            continue;
+        }
+        uint64_t units = at >= 0.0 ? uint64_t(std::llround(at / courseUnit)) : 0;
+        bool known = fields == 2 && (strcmp(kind, "spike") == 0 || strcmp(kind, "floating") == 0);
+        if (!known || at < 0.0 || units < position || units - position >= courseEndGap) {
+            printf("line %llu: expected \"<position> spike|floating\" with positions in order\n",
+                   (unsigned long long)line);
+            error = true;
+            return false;
+        }
+        obstacle.gap = uint32_t(units - position);
+        obstacle.kind = strcmp(kind, "spike") == 0 ? COURSE_SPIKE : COURSE_FLOATING_SPIKE;
+        position = units;
+        return true;
+    }
+    return false;
+}
+
+static int courseFileCommand(int argc, char** argv) {
+    SimConfig config;
+    const char* outPath = nullptr;
+    const char* textPath = nullptr;
+    uint32_t seed = 0;
+    uint64_t count = 100000;
+    bool check = false;
+
+    for (int i = 0; i < argc; ++i) {
+        if (strcmp(argv[i], "--out") == 0 && i + 1 < argc) {
+            outPath = argv[++i];
+        } else if (strcmp(argv[i], "--seed") == 0 && i + 1 < argc) {
+            seed = uint32_t(strtoul(argv[++i], nullptr, 10));
+        } else if (strcmp(argv[i], "--obstacles") == 0 && i + 1 < argc) {
+            count = strtoull(argv[++i], nullptr, 10);
+        } else if (strcmp(argv[i], "--from") == 0 && i + 1 < argc) {
+            textPath = argv[++i];
+        } else if (strcmp(argv[i], "--check") == 0) {
+            check = true;
+        } else {
+            printUsage();
+            return 1;
+        }
+    }
+    if (!outPath) {
+        printUsage();
+        return 1;
+    }
+
+    // Stream the source into the file; neither is ever held whole
+    FILE* text = nullptr;
+    if (textPath) {
+        text = fopen(textPath, "r");
+        if (!text) {
+            printf("Cannot open %s\n", textPath);
+            return 1;
+        }
+    }
+    uint64_t line = 0;
+    uint64_t position = 0;
+    uint64_t written = 0;
+    bool textError = false;
+    CourseObstacle generated[courseChunkSize];
+    auto next = [&](CourseObstacle& obstacle) {
+        if (text) {
+            return readTextObstacle(text, line, position, obstacle, textError);
+        }
+        if (written == count) {
+            return false;
+        }
+        if (written % courseChunkSize == 0) {
+            courseGenerateChunk(seed, written / courseChunkSize, generated);
+        }
+        obstacle = generated[written++ % courseChunkSize];
+        return true;
+    };
+    auto start = std::chrono::steady_clock::now();
+    bool ok = courseFileWrite(outPath, next);
+    double writeSeconds = secondsSince(start);
+    if (text) {
+        fclose(text);
+    }
+    if (!ok || textError) {
+        return 1;
+    }
+
+    start = std::chrono::steady_clock::now();
+    CourseFile course;
+    if (!course.map(outPath)) {
+        return 1;
+    }
+    double openSeconds = secondsSince(start);
+
+    // Decode every chunk; a generated course must match the generator
+    CourseObstacle obstacles[courseChunkSize];
+    uint64_t mismatches = 0;
+    start = std::chrono::steady_clock::now();
+    for (uint64_t c = 0; c < course.chunkCount(); ++c) {
+        if (!course.readChunk(c, obstacles)) {
+            return 1;
+        }
+        if (!textPath) {
+            courseGenerateChunk(seed, c, generated);
+            for (size_t i = 0; i < courseChunkSize && c * courseChunkSize + i < count; ++i) {
+                mismatches += obstacles[i].gap != generated[i].gap ||
+                              obstacles[i].kind != generated[i].kind;
+            }
+        }
+    }
+    double decodeSeconds = secondsSince(start);
+
+    // The index is the end of the file
+    uint64_t bytes = course.chunkOffset(course.chunkCount()) + (course.chunkCount() + 1) * 8;
+    uint64_t obstacleCount = course.obstacleCount();
+    printf("course:       %llu obstacles in %llu chunks\n", (unsigned long long)obstacleCount,
+           (unsigned long long)course.chunkCount());
+    printf("file size:    %llu bytes (%.2f bytes/obstacle)\n", (unsigned long long)bytes,
+           obstacleCount > 0 ? double(bytes) / double(obstacleCount) : 0.0);
+    printf("write time:   %.3f ms\n", writeSeconds * 1e3);
+    printf("open time:    %.3f ms\n", openSeconds * 1e3);
+    printf("obstacles decoded/second: %.0f\n",
+           decodeSeconds > 0.0 ? double(obstacleCount) / decodeSeconds : 0.0);
+    if (!textPath) {
+        printf("mismatches:   %llu\n", (unsigned long long)mismatches);
+    }
+    if (mismatches > 0) {
+        return 1;
+    }
+    if (!check) {
+        return 0;
+    }
+
+    // The validator carries its state across a whole run of obstacles, so
+    // chunks are checked with the previous chunk's tail in front of them.
+    CourseJumpWindows windows;
+    if (!courseJumpWindows(config, windows)) {
+        printf("No jump clears a ground spike at this tick rate and scroll speed\n");
+        return 1;
+    }
+    const size_t overlap = 8;
+    CourseObstacle run[overlap + courseChunkSize];
+    size_t carried = 0;
+    uint64_t failed = 0;
+    for (uint64_t c = 0; c < course.chunkCount(); ++c) {
+        course.readChunk(c, run + carried);
+        size_t length = carried + courseChunkSize;
+        if (c == course.chunkCount() - 1) {
+            length = carried + size_t(obstacleCount - c * courseChunkSize);
+        }
+        size_t cleared = courseCheckObstacles(config, windows, run, length);
+        if (cleared < length && cleared >= carried) {
+            if (failed < 10) {
+                printf("obstacle %llu can't be cleared\n",
+                       (unsigned long long)(c * courseChunkSize + cleared - carried));
+            }
+            ++failed;
+        }
+        carried = length < overlap ? length : overlap;
+        memmove(run, run + length - carried, carried * sizeof(CourseObstacle));
+    }
+    printf("unclearable:  %llu of %llu chunks\n", (unsigned long long)failed,
+           (unsigned long long)course.chunkCount());
+    return failed > 0 ? 1 : 0;
+}
+
+// ------------------------------------------------------
+// snapshot-bench: fill a snapshot ring from a bot run, so the snapshots
+// hold the obstacle counts of real play, then time saving and restoring
+// them. Also rolls back to every snapshot and re-simulates to check that
+// a restored state continues exactly as the original did.
+// ------------------------------------------------------
+static int snapshotBenchCommand(int argc, char** argv) {
+    SimConfig config;
+    size_t ringSize = 600;
+    uint64_t count = 10000000;
+
+    for (int i = 0; i < argc; ++i) {
+        if (strcmp(argv[i], "--ring") == 0 && i + 1 < argc) {
+            ringSize = strtoull(argv[++i], nullptr, 10);
+        } else if (strcmp(argv[i], "--count") == 0 && i + 1 < argc) {
+            count = strtoull(argv[++i], nullptr, 10);
+        } else if (strcmp(argv[i], "--seed") == 0 && i + 1 < argc) {
+            config.seed = uint32_t(strtoul(argv[++i], nullptr, 10));
+        } else {
+            printUsage();
+            return 1;
+        }
+    }
+    if (ringSize == 0) {
+        printUsage();
+        return 1;
+    }
+
+    // One snapshot per tick of a bot run, after the first spikes are on
+    // screen
+    SnapshotRing ring(ringSize);
+    SimState state;
+    simInit(state, config);
+    while (state.spikes.size() < 2) {
+        simUpdate(state, config, botWantsJump(state, config) ? SIM_INPUT_JUMP : 0);
+    }
+    uint64_t spikes = 0;
+    for (size_t i = 0; i < ringSize; ++i) {
+        ring.push(state);
+        spikes += state.spikes.size();
+        simUpdate(state, config, botWantsJump(state, config) ? SIM_INPUT_JUMP : 0);
+    }
+    SimState end = state;
+
+    // Roll back to every snapshot and run forward to the end again
+    uint64_t mismatches = 0;
+    for (size_t age = 0; age < ring.size(); ++age) {
+        simRestore(state, ring.fromNewest(age));
+        while (state.tick < end.tick) {
+            simUpdate(state, config, botWantsJump(state, config) ? SIM_INPUT_JUMP : 0);
+        }
+        mismatches += !sameState(state, end);
+    }
+    const SimSnapshot& newest = ring.fromNewest(0);
+    const SimSnapshot& oldest = ring.fromNewest(ring.size() - 1);
+    if (ring.atOrBefore(end.tick) != &newest || ring.atOrBefore(oldest.state.tick - 1) ||
+        (ring.size() > 1 && ring.atOrBefore(newest.state.tick - 1) != &ring.fromNewest(1))) {
+        ++mismatches;
+    }
+
+    // Saves cycle through the ring's real states, so each copies a
+    // different slot
+    SnapshotRing saves(ringSize);
+    auto start = std::chrono::steady_clock::now();
+    for (uint64_t i = 0; i < count; ++i) {
+        saves.push(ring.fromNewest(i % ringSize).state);
+    }
+    double saveSeconds = secondsSince(start);
+
+    uint64_t checksum = 0;
+    start = std::chrono::steady_clock::now();
+    for (uint64_t i = 0; i < count; ++i) {
+        simRestore(state, ring.fromNewest(i % ringSize));
+        checksum += state.tick; // keeps the restores from being optimized away
+    }
+    double restoreSeconds = secondsSince(start);
+
+    printf("snapshot size: %zu bytes (ring of %zu: %.1f KB)\n", sizeof(SimSnapshot), ringSize,
+           double(sizeof(SimSnapshot) * ringSize) / 1024.0);
+    printf("spikes:        %.1f on screen on average\n", double(spikes) / double(ringSize));
+    printf("rollbacks:     %zu, %llu mismatches\n", ring.size(), (unsigned long long)mismatches);
+    printf("saves/second:    %.0f\n", saveSeconds > 0.0 ? double(count) / saveSeconds : 0.0);
+    printf("restores/second: %.0f (checksum %llu)\n",
+           restoreSeconds > 0.0 ? double(count) / restoreSeconds : 0.0,
+           (unsigned long long)checksum);
+    return mismatches > 0 ? 1 : 0;
+}
+
+// ------------------------------------------------------
+// rewind: run a bot that now and then stops paying attention, keeping a
+// rewind history, then step back through the ticks leading up to the last
+// collision. Every tick in the history is rebuilt and checked against the
+// state the run actually had; reports the history's memory cost and the
+// seek time.
+// ------------------------------------------------------
+
+// One line per tick: the player and the spike nearest to it
+static void printRewindTick(const SimState& state, uint32_t input) {
+    const Spike* nearest = nullptr;
+    for (const auto &spike : state.spikes) {
+        if (!nearest || std::fabs(spike.x) < std::fabs(nearest->x)) {
+            nearest = &spike;
+        }
+    }
+    printf("  tick %8llu  playerY %9.6f  %-9s", (unsigned long long)state.tick, state.playerY,
+           state.isOnGround ? "on ground" : "in air");
+    if (nearest) {
+        printf("  nearest spike at (%9.6f, %9.6f)", nearest->x, nearest->y);
+    }
+    printf("%s\n", (input & SIM_INPUT_JUMP) ? "  jump" : "");
+}
+
+static int rewindCommand(int argc, char** argv) {
+    SimConfig config;
+    uint64_t ticks = 100000;
+    double seconds = 60.0;
+    uint32_t keyframe = 30;
+
+    for (int i = 0; i < argc; ++i) {
+        if (strcmp(argv[i], "--ticks") == 0 && i + 1 < argc) {
+            ticks = strtoull(argv[++i], nullptr, 10);
+        } else if (strcmp(argv[i], "--seconds") == 0 && i + 1 < argc) {
+            seconds = atof(argv[++i]);
+        } else if (strcmp(argv[i], "--keyframe") == 0 && i + 1 < argc) {
+            keyframe = uint32_t(strtoul(argv[++i], nullptr, 10));
+        } else if (strcmp(argv[i], "--seed") == 0 && i + 1 < argc) {
+            config.seed = uint32_t(strtoul(argv[++i], nullptr, 10));
+        } else {
+            printUsage();
+            return 1;
+        }
+    }
+    uint64_t historyTicks = uint64_t(seconds * config.tickRate);
+    if (historyTicks == 0 || keyframe == 0) {
+        printUsage();
+        return 1;
+    }
+
+    RewindHistory history;
+    history.reset(historyTicks, keyframe);
+
+    // The hash of every state the run passes through, to check rebuilds
+    // against (a ring as long as the history)
+    std::vector<SimStateHash> truth(size_t(historyTicks + keyframe));
+    SimState state;
+    simInit(state, config);
+    uint64_t lastCollision = UINT64_MAX;
+    auto start = std::chrono::steady_clock::now();
+    for (uint64_t t = 0; t < ticks; ++t) {
+        bool distracted = (state.tick / 600) % 5 == 2;
+        uint32_t input = (!distracted && botWantsJump(state, config)) ? SIM_INPUT_JUMP : 0;
+        simHashState(state, truth[state.tick % truth.size()]);
+        history.record(state, input);
+        if (simUpdate(state, config, input)) {
+            lastCollision = state.tick - 1;
+        }
+    }
+    double recordSeconds = secondsSince(start);
+
+    // Rebuild every tick in the history
+    uint64_t first = history.firstTick();
+    uint64_t mismatches = 0;
+    SimState rebuilt;
+    SimStateHash hash;
+    start = std::chrono::steady_clock::now();
+    for (uint64_t tick = first; tick < history.endTick(); ++tick) {
+        if (!history.seek(tick, config, rebuilt)) {
+            ++mismatches;
+            continue;
+        }
+        simHashState(rebuilt, hash);
+        mismatches += hash != truth[tick % truth.size()];
+    }
+    double seekSeconds = secondsSince(start);
+    uint64_t seeks = history.endTick() - first;
+
+    if (lastCollision != UINT64_MAX && lastCollision >= first) {
+        printf("last collision at tick %llu; the ticks before it:\n",
+               (unsigned long long)lastCollision);
+        uint64_t from = lastCollision >= first + 5 ? lastCollision - 5 : first;
+        for (uint64_t tick = from; tick <= lastCollision; ++tick) {
+            history.seek(tick, config, rebuilt);
+            printRewindTick(rebuilt, history.inputAt(tick));
+        }
+        history.seek(lastCollision + 1, config, rebuilt);
+        printf("  after the collision the player is back on the ground with %zu spikes\n",
+               rebuilt.spikes.size());
+    }
+
+    double perMinute = history.bytesPerMinute(config.tickRate);
+    double everyTick = 60.0 * config.tickRate * double(sizeof(SimSnapshot));
+    printf("history:      ticks %llu to %llu (%.1f s), keyframe every %u ticks\n",
+           (unsigned long long)first, (unsigned long long)history.endTick(),
+           double(history.endTick() - first) / config.tickRate, keyframe);
+    printf("memory:       %.1f KB preallocated, %.1f KB per minute of history\n"
+           "              (%.1f KB per minute with a snapshot every tick)\n",
+           double(history.memoryBytes()) / 1024.0, perMinute / 1024.0, everyTick / 1024.0);
+    printf("recording:    %.0f ticks/second\n", recordSeconds > 0.0 ? double(ticks) / recordSeconds : 0.0);
+    printf("rebuilt:      %llu ticks, %llu mismatches, %.2f us per seek\n", (unsigned long long)seeks,
+           (unsigned long long)mismatches, seeks > 0 ? seekSeconds * 1e6 / double(seeks) : 0.0);
+    return mismatches > 0 ? 1 : 0;
+}
+
+// Paths of the replay files (*.bgr) in a directory, sorted
+static bool listReplays(const char* dir, std::vector<std::string>& paths) {
+    DIR* d = opendir(dir);
+    if (!d) {
+        printf("Cannot open directory %s\n", dir);
+        return false;
+    }
+    while (dirent* entry = readdir(d)) {
+        size_t length = strlen(entry->d_name);
+        if (length > 4 && strcmp(entry->d_name + length - 4, ".bgr") == 0) {
+            paths.push_back(std::string(dir) + "/" + entry->d_name);
+        }
+    }
+    closedir(d);
+    std::sort(paths.begin(), paths.end());
+    return true;
+}
+
+// ------------------------------------------------------
+// A bot run to submit in load tests: the run bot, looking away now and
+// then (when depends on the seed) so runs end with different scores.
+// Returns the replay file and its score.
+// ------------------------------------------------------
+static uint64_t botReplay(uint32_t seed, uint64_t ticks, std::vector<uint8_t>& out) {
+    SimConfig config;
+    config.seed = seed;
+    SimState state;
+    simInit(state, config);
+    ReplayRecorder recorder;
+    recorder.begin(config);
+    std::vector<uint64_t> collisionTicks;
+    for (uint64_t t = 0; t < ticks; ++t) {
+        bool distracted = (state.tick / 600 + seed) % 7 == 3;
+        uint32_t input = (!distracted && botWantsJump(state, config)) ? SIM_INPUT_JUMP : 0;
+        recorder.recordTick(state.tick, input);
+        if (simUpdate(state, config, input)) {
+            collisionTicks.push_back(state.tick - 1);
+        }
+    }
+    recorder.end();
+    replaySerialize(recorder.replay(), out);
+    return verifyScore(config, ticks, collisionTicks);
+}
+
+static void printVerdictTotals(const uint64_t counts[VERIFY_RESULT_COUNT]) {
+    printf("verdicts:     %llu accepted, %llu wrong score, %llu invalid\n",
+           (unsigned long long)counts[VERIFY_ACCEPTED], (unsigned long long)counts[VERIFY_WRONG_SCORE],
+           (unsigned long long)counts[VERIFY_INVALID]);
+}
+
+// ------------------------------------------------------
+// verify --listen: the local submission endpoint. Serves until `count`
+// submissions have been verified (0: forever).
+// ------------------------------------------------------
+static int verifyServe(WorkPool& pool, uint16_t port, uint64_t count, bool quiet) {
+    std::mutex mutex;
+    std::condition_variable done;
+    uint64_t counts[VERIFY_RESULT_COUNT] = {};
+    uint64_t verified = 0;
+    double simSeconds = 0.0;
+    SubmissionServer server(pool, [&](const VerifyVerdict& verdict, uint64_t id) {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (!quiet) {
+            printf("submission %llu: %-11s score %llu, %llu ticks, %.3f ms%s%s\n",
+                   (unsigned long long)id, verifyResultNames[verdict.result],
+                   (unsigned long long)verdict.score, (unsigned long long)verdict.ticks,
+                   verdict.simSeconds * 1e3, *verdict.reason ? ": " : "", verdict.reason);
+        }
+        ++counts[verdict.result];
+        simSeconds += verdict.simSeconds;
+        if (++verified == count) {
+            done.notify_all();
+        }
+    });
+    if (!server.start(port)) {
+        printf("Cannot listen on port %u\n", unsigned(port));
+        return 1;
+    }
+    printf("listening on 127.0.0.1:%u, %zu verifier threads\n", unsigned(server.port()),
+           pool.threadCount());
+    fflush(stdout);
+
+    auto start = std::chrono::steady_clock::now();
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        done.wait(lock, [&] { return count > 0 && verified >= count; });
+    }
+    double seconds = secondsSince(start);
+    // Waits for the clients to hang up
+    server.stop();
+    printf("submissions:  %llu in %.3f s of listening\n", (unsigned long long)verified, seconds);
+    printVerdictTotals(counts);
+    printf("verify time:  %.3f ms average\n", verified > 0 ? simSeconds * 1e3 / double(verified) : 0.0);
+    return 0;
+}
+
+// ------------------------------------------------------
+// verify: check every replay in a directory across all cores, or serve
+// the submission endpoint on a loopback port
+// ------------------------------------------------------
+static int verifyCommand(int argc, char** argv) {
+    const char* dir = nullptr;
+    int port = -1;
+    size_t threads = 0;
+    uint64_t count = 0;
+    bool quiet = false;
+
+    for (int i = 0; i < argc; ++i) {
+        if (strcmp(argv[i], "--listen") == 0 && i + 1 < argc) {
+            port = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--threads") == 0 && i + 1 < argc) {
+            threads = size_t(strtoul(argv[++i], nullptr, 10));
+        } else if (strcmp(argv[i], "--count") == 0 && i + 1 < argc) {
+            count = strtoull(argv[++i], nullptr, 10);
+        } else if (strcmp(argv[i], "--quiet") == 0) {
+            quiet = true;
+        } else if (argv[i][0] != '-' && !dir) {
+            dir = argv[i];
+        } else {
+            printUsage();
+            return 1;
+        }
+    }
+    if ((dir != nullptr) == (port >= 0) || port > 65535) {
+        printUsage();
+        return 1;
+    }
+
+    WorkPool pool(threads);
+    if (port >= 0) {
+        return verifyServe(pool, uint16_t(port), count, quiet);
+    }
+
+    std::vector<std::string> paths;
+    if (!listReplays(dir, paths)) {
+        return 1;
+    }
+    std::vector<VerifyVerdict> verdicts(paths.size());
+    auto start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < paths.size(); ++i) {
+        pool.submit([&, i] {
+            std::vector<uint8_t> bytes;
+            if (readFileBytes(paths[i].c_str(), bytes)) {
+                verdicts[i] = verifyReplay(bytes.data(), bytes.size(), verifyNoClaim);
+            } else {
+                verdicts[i].reason = "cannot read the file";
+            }
+        });
+    }
+    pool.wait();
+    double seconds = secondsSince(start);
+
+    uint64_t counts[VERIFY_RESULT_COUNT] = {};
+    uint64_t ticks = 0;
+    double simSeconds = 0.0;
+    for (size_t i = 0; i < paths.size(); ++i) {
+        const VerifyVerdict& verdict = verdicts[i];
+        if (!quiet) {
+            printf("%s: %s, score %llu, %llu ticks, %.3f ms%s%s\n", paths[i].c_str(),
+                   verifyResultNames[verdict.result], (unsigned long long)verdict.score,
+                   (unsigned long long)verdict.ticks, verdict.simSeconds * 1e3,
+                   *verdict.reason ? ": " : "", verdict.reason);
+        }
+        ++counts[verdict.result];
+        ticks += verdict.ticks;
+        simSeconds += verdict.simSeconds;
+    }
+    printf("replays:      %zu in %.3f s on %zu threads (%llu steals)\n", paths.size(), seconds,
+           pool.threadCount(), (unsigned long long)pool.steals());
+    printVerdictTotals(counts);
+    printf("sim time:     %.3f s summed over the replays, %.2f verifying at once on average\n",
+           simSeconds, seconds > 0.0 ? simSeconds / seconds : 0.0);
+    printf("throughput:   %.0f replays/second, %.0f ticks/second\n",
+           seconds > 0.0 ? double(paths.size()) / seconds : 0.0,
+           seconds > 0.0 ? double(ticks) / seconds : 0.0);
+    return counts[VERIFY_ACCEPTED] == paths.size() ? 0 : 1;
+}
+
+// ------------------------------------------------------
+// One load-test connection: send its submissions with at most `window`
+// awaiting a verdict, recording each verdict and its round-trip time
+// ------------------------------------------------------
+struct LoadTest {
+    std::vector<std::vector<uint8_t>> replays;
+    std::vector<uint64_t> claims;
+    std::vector<SubmissionVerdict> verdicts;
+    std::vector<double> latencies; // seconds; negative until the verdict arrives
+};
+
+static bool loadConnection(uint16_t port, LoadTest& test, size_t first, size_t stride,
+                           size_t window) {
+    int s = submissionConnect(port);
+    if (s < 0) {
+        printf("Cannot connect to 127.0.0.1:%u\n", unsigned(port));
+        return false;
+    }
+    std::mutex mutex;
+    std::condition_variable ready;
+    size_t inFlight = 0;
+    bool failed = false;
+    std::vector<std::chrono::steady_clock::time_point> sent(test.replays.size());
+
+    size_t expected = 0;
+    for (size_t id = first; id < test.replays.size(); id += stride) {
+        ++expected;
+    }
+    std::thread receiver([&] {
+        for (size_t n = 0; n < expected; ++n) {
+            SubmissionVerdict verdict;
+            bool ok = submissionReceive(s, verdict) && verdict.id < test.replays.size();
+            std::lock_guard<std::mutex> lock(mutex);
+            if (!ok) {
+                failed = true;
+                ready.notify_all();
+                return;
+            }
+            test.latencies[verdict.id] = secondsSince(sent[verdict.id]);
+            test.verdicts[verdict.id] = verdict;
+            --inFlight;
+            ready.notify_all();
+        }
+    });
+    for (size_t id = first; id < test.replays.size(); id += stride) {
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            ready.wait(lock, [&] { return inFlight < window || failed; });
+            if (failed) {
+                break;
+            }
+            ++inFlight;
+            sent[id] = std::chrono::steady_clock::now();
+        }
+        if (!submissionSend(s, id, test.claims[id], test.replays[id])) {
+            submissionShutdown(s);
+            break;
+        }
+    }
+    receiver.join();
+    submissionClose(s);
+    return !failed;
+}
+
+// ------------------------------------------------------
+// submit: load-test a submission endpoint with generated bot runs or the
+// replays in a directory. With --local the endpoint runs in-process.
+// ------------------------------------------------------
+static int submitCommand(int argc, char** argv) {
+    int port = -1;
+    bool local = false;
+    const char* dir = nullptr;
+    const char* saveDir = nullptr;
+    uint64_t generate = 0;
+    uint64_t ticks = 36000;
+    size_t connections = 4;
+    size_t window = 16;
+    uint64_t cheatEvery = 0;
+    size_t threads = 0;
+
+    for (int i = 0; i < argc; ++i) {
+        if (strcmp(argv[i], "--port") == 0 && i + 1 < argc) {
+            port = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--local") == 0) {
+            local = true;
+        } else if (strcmp(argv[i], "--generate") == 0 && i + 1 < argc) {
+            generate = strtoull(argv[++i], nullptr, 10);
+        } else if (strcmp(argv[i], "--ticks") == 0 && i + 1 < argc) {
+            ticks = strtoull(argv[++i], nullptr, 10);
+        } else if (strcmp(argv[i], "--save") == 0 && i + 1 < argc) {
+            saveDir = argv[++i];
+        } else if (strcmp(argv[i], "--connections") == 0 && i + 1 < argc) {
+            connections = size_t(strtoul(argv[++i], nullptr, 10));
+        } else if (strcmp(argv[i], "--window") == 0 && i + 1 < argc) {
+            window = size_t(strtoul(argv[++i], nullptr, 10));
+        } else if (strcmp(argv[i], "--cheat-every") == 0 && i + 1 < argc) {
+            cheatEvery = strtoull(argv[++i], nullptr, 10);
+        } else if (strcmp(argv[i], "--threads") == 0 && i + 1 < argc) {
+            threads = size_t(strtoul(argv[++i], nullptr, 10));
+        } else if (argv[i][0] != '-' && !dir) {
+            dir = argv[i];
+        } else {
+            printUsage();
+            return 1;
+        }
+    }
+    if (local == (port >= 0) || port > 65535 || (dir != nullptr) == (generate > 0) ||
+        connections == 0 || window == 0 || (saveDir && !generate)) {
+        printUsage();
+        return 1;
+    }
+
+    // The submissions, with the scores their runs really made
+    WorkPool pool(threads);
+    LoadTest test;
+    std::vector<uint64_t> scores;
+    std::vector<char> valid;
+    uint64_t totalTicks = 0;
+    if (generate > 0) {
+        test.replays.resize(size_t(generate));
+        scores.resize(size_t(generate));
+        for (size_t i = 0; i < test.replays.size(); ++i) {
+            pool.submit([&, i] { scores[i] = botReplay(uint32_t(i + 1), ticks, test.replays[i]); });
+        }
+        pool.wait();
+        valid.assign(test.replays.size(), 1);
+        totalTicks = generate * ticks;
+        for (size_t i = 0; saveDir && i < test.replays.size(); ++i) {
+            char path[1024];
+            snprintf(path, sizeof(path), "%s/%06zu.bgr", saveDir, i);
+            FILE* file = fopen(path, "wb");
+            if (!file) {
+                printf("Cannot open %s for writing\n", path);
+                return 1;
+            }
+            fwrite(test.replays[i].data(), 1, test.replays[i].size(), file);
+            fclose(file);
+        }
+    } else {
+        std::vector<std::string> paths;
+        if (!listReplays(dir, paths)) {
+            return 1;
+        }
+        // What the replays score when verified here; unreadable ones
+        // should come back invalid
+        for (const auto &path : paths) {
+            test.replays.emplace_back();
+            if (!readFileBytes(path.c_str(), test.replays.back())) {
+                return 1;
+            }
+            VerifyVerdict verdict =
+                verifyReplay(test.replays.back().data(), test.replays.back().size(), verifyNoClaim);
+            scores.push_back(verdict.score);
+            valid.push_back(verdict.result == VERIFY_ACCEPTED);
+            totalTicks += verdict.ticks;
+        }
+    }
+    // Cheaters claim a little more than they made
+    for (size_t i = 0; i < scores.size(); ++i) {
+        bool cheat = cheatEvery > 0 && (i + 1) % cheatEvery == 0;
+        test.claims.push_back(cheat ? scores[i] + 1000 : scores[i]);
+    }
+    test.verdicts.resize(test.replays.size());
+    test.latencies.assign(test.replays.size(), -1.0);
+
+    std::unique_ptr<SubmissionServer> server;
+    if (local) {
+        server.reset(new SubmissionServer(pool));
+        if (!server->start(0)) {
+            printf("Cannot start the local endpoint\n");
+            return 1;
+        }
+        port = server->port();
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    std::vector<std::thread> clients;
+    std::vector<char> connected(connections, 0);
+    for (size_t c = 0; c < connections; ++c) {
+        clients.emplace_back([&, c] { connected[c] = loadConnection(uint16_t(port), test, c, connections, window); });
+    }
+    for (auto &client : clients) {
+        client.join();
+    }
+    double seconds = secondsSince(start);
+    if (server) {
+        server->stop();
+    }
+
+    // Tally: honest claims should be accepted, inflated ones refused and
+    // broken replays found invalid
+    uint64_t counts[VERIFY_RESULT_COUNT] = {};
+    uint64_t unexpected = 0;
+    double verifySeconds = 0.0;
+    std::vector<double> latencies;
+    for (size_t i = 0; i < test.replays.size(); ++i) {
+        if (test.latencies[i] < 0.0) {
+            ++unexpected;
+            continue;
+        }
+        const SubmissionVerdict& verdict = test.verdicts[i];
+        ++counts[verdict.result];
+        verifySeconds += double(verdict.verifyNanoseconds) * 1e-9;
+        latencies.push_back(test.latencies[i]);
+        VerifyResult wanted = !valid[i]                     ? VERIFY_INVALID
+                              : test.claims[i] == scores[i] ? VERIFY_ACCEPTED
+                                                            : VERIFY_WRONG_SCORE;
+        if (verdict.result != wanted || verdict.score != scores[i]) {
+            ++unexpected;
+        }
+    }
+    std::sort(latencies.begin(), latencies.end());
+    auto percentile = [&](double p) {
+        return latencies.empty() ? 0.0 : latencies[size_t(p * double(latencies.size() - 1))] * 1e3;
+    };
+
+    printf("endpoint:     127.0.0.1:%d%s\n", port, local ? " (in-process)" : "");
+    printf("submissions:  %zu over %zu connections, up to %zu in flight each\n", test.replays.size(),
+           connections, window);
+    printVerdictTotals(counts);
+    printf("unexpected:   %llu\n", (unsigned long long)unexpected);
+    printf("wall time:    %.3f s\n", seconds);
+    printf("throughput:   %.0f submissions/second, %.0f ticks/second\n",
+           seconds > 0.0 ? double(latencies.size()) / seconds : 0.0,
+           seconds > 0.0 ? double(totalTicks) / seconds : 0.0);
+    printf("latency:      %.3f ms median, %.3f ms p99, %.3f ms max\n", percentile(0.5),
+           percentile(0.99), percentile(1.0));
+    printf("verify time:  %.3f ms average per replay\n",
+           latencies.empty() ? 0.0 : verifySeconds * 1e3 / double(latencies.size()));
+    bool allConnected = std::find(connected.begin(), connected.end(), 0) == connected.end();
+    return (unexpected == 0 && allConnected) ? 0 : 1;
+}
+
+// ------------------------------------------------------
+// gym-bench: step batches of gym environments (gym.h), one batch per
+// thread, with a policy that only sees the observations, and report
+// environment steps per second per core. Environment 0 of the first batch
+// is checked against a plain simUpdate() run of the same course and
+// actions.
+// ------------------------------------------------------
+static int gymBenchCommand(int argc, char** argv) {
+    int envCount = 256;
+    uint64_t steps = 20000;
+    int lookahead = 4;
+    size_t threadCount = 1;
+    uint32_t seed = 0;
+
+    for (int i = 0; i < argc; ++i) {
+        if (strcmp(argv[i], "--envs") == 0 && i + 1 < argc) {
+            envCount = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--steps") == 0 && i + 1 < argc) {
+            steps = strtoull(argv[++i], nullptr, 10);
+        } else if (strcmp(argv[i], "--lookahead") == 0 && i + 1 < argc) {
+            lookahead = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--threads") == 0 && i + 1 < argc) {
+            threadCount = size_t(strtoul(argv[++i], nullptr, 10));
+        } else if (strcmp(argv[i], "--seed") == 0 && i + 1 < argc) {
+            seed = uint32_t(strtoul(argv[++i], nullptr, 10));
+        } else {
+            printUsage();
+            return 1;
+        }
+    }
+    if (envCount <= 0 || lookahead <= 0 || threadCount == 0) {
+        printUsage();
+        return 1;
+    }
+
+    struct Worker {
+        double stepSeconds = 0.0; // inside gymStep() only
+        uint64_t episodes = 0;
+        uint64_t mismatches = 0;
+    };
+    std::vector<Worker> workers(threadCount);
+    auto work = [&](size_t t) {
+        Worker& worker = workers[t];
+        GymEnvs* envs = gymCreate(envCount, lookahead, 0);
+        if (!envs) {
+            ++worker.mismatches;
+            return;
+        }
+        size_t observationSize = size_t(gymObservationSize(envs));
+        size_t count = static_cast<size_t>(envCount);
+        std::vector<float> observations(count * observationSize);
+        std::vector<float> rewards(count);
+        std::vector<uint8_t> dones(count);
+        std::vector<uint8_t> actions(count);
+        gymSetBuffers(envs, observations.data(), rewards.data(), dones.data());
+        uint32_t batchSeed = seed + uint32_t(t) * uint32_t(envCount) * 1000u;
+        gymReset(envs, batchSeed);
+
+        // Reference for environment 0: its first course
+        SimConfig config;
+        config.seed = batchSeed;
+        SimState reference;
+        simInit(reference, config);
+        bool checking = t == 0;
+
+        for (uint64_t s = 0; s < steps; ++s) {
+            // The bot from run, on observations: jump when the nearest
+            // ground spike is about to arrive. Every 13th environment
+            // is clumsy and misses some, so episodes end.
+            for (int e = 0; e < envCount; ++e) {
+                const float* o = observations.data() + size_t(e) * observationSize;
+                bool jump = o[4] == 0.0f && o[3] > 0.28f && o[3] < 0.36f;
+                actions[e] = (jump && !(e % 13 == 12 && (s / 500) % 4 == 1)) ? 1 : 0;
+            }
+            auto start = std::chrono::steady_clock::now();
+            worker.episodes += uint64_t(gymStep(envs, actions.data()));
+            worker.stepSeconds += secondsSince(start);
+
+            if (checking) {
+                bool collided = simUpdate(reference, config, actions[0] ? SIM_INPUT_JUMP : 0);
+                if (collided != (dones[0] == GYM_TERMINATED) ||
+                    (!collided && !sameBits(observations[0], reference.playerY - config.groundY))) {
+                    ++worker.mismatches;
+                }
+                // The next episode is on another course
+                checking = !collided;
+            }
+        }
+        gymDestroy(envs);
+    };
+    auto start = std::chrono::steady_clock::now();
+    std::vector<std::thread> threads;
+    for (size_t t = 0; t < threadCount; ++t) {
+        threads.emplace_back(work, t);
+    }
+    for (auto &thread : threads) {
+        thread.join();
+    }
+    double seconds = secondsSince(start);
+
+    double stepSeconds = 0.0;
+    uint64_t episodes = 0;
+    uint64_t mismatches = 0;
+    for (const auto &worker : workers) {
+        stepSeconds += worker.stepSeconds;
+        episodes += worker.episodes;
+        mismatches += worker.mismatches;
+    }
+    uint64_t envSteps = uint64_t(envCount) * steps * threadCount;
+    printf("environments: %d per thread x %zu threads, %d floats per observation\n", envCount,
+           threadCount, 3 + 2 * lookahead);
+    printf("env steps:    %llu (%llu episodes ended, %.0f steps per episode)\n",
+           (unsigned long long)envSteps, (unsigned long long)episodes,
+           episodes > 0 ? double(envSteps) / double(episodes) : 0.0);
+    printf("wall time:    %.3f s, %.0f env steps/second with the policy\n", seconds,
+           seconds > 0.0 ? double(envSteps) / seconds : 0.0);
+    printf("per core:     %.0f env steps/second in gymStep()\n",
+           stepSeconds > 0.0 ? double(envSteps) / stepSeconds : 0.0);
+    printf("check:        %s\n", mismatches == 0 ? "environment 0 matches simUpdate()" : "MISMATCH");
+    return mismatches > 0 ? 1 : 0;
+}
+
+// ------------------------------------------------------
+// One game played by the search bot, timing every decision
+// ------------------------------------------------------
+struct SearchGame {
+    uint64_t collisions = 0;
+    double searchSeconds = 0.0;
+    double slowestDecision = 0.0;
+    SearchStats stats;
+    std::vector<uint8_t> inputs; // every tick's input, if kept
+};
+
+static void playSearchGame(SearchBot& bot, uint32_t seed, uint64_t ticks, bool keepInputs,
+                           SearchGame& game) {
+    SimConfig config;
+    config.seed = seed;
+    SimState state;
+    simInit(state, config);
+    SearchStats before = bot.stats();
+    for (uint64_t t = 0; t < ticks; ++t) {
+        auto start = std::chrono::steady_clock::now();
+        uint32_t input = bot.decide(state, config);
+        double seconds = secondsSince(start);
+        game.searchSeconds += seconds;
+        game.slowestDecision = seconds > game.slowestDecision ? seconds : game.slowestDecision;
+        if (keepInputs) {
+            game.inputs.push_back(uint8_t(input));
+        }
+        game.collisions += simUpdate(state, config, input);
+    }
+    const SearchStats& after = bot.stats();
+    game.stats.decisions = after.decisions - before.decisions;
+    game.stats.nodes = after.nodes - before.nodes;
+    game.stats.updates = after.updates - before.updates;
+    game.stats.memoHits = after.memoHits - before.memoHits;
+}
+
+// ------------------------------------------------------
+// search-bot: play games with the lookahead search bot (search_bot.h),
+// several at once on the work pool, or one at a time with each search
+// split across it (--split), and report search nodes per second, the
+// slowest decision against the tick budget, and how often even the
+// search can't avoid a spike. --check replays the first game the other
+// way and checks every decision matches.
+// ------------------------------------------------------
+static int searchBotCommand(int argc, char** argv) {
+    uint64_t games = 100;
+    double seconds = 60.0;
+    double horizon = 3.0;
+    size_t threads = 0;
+    bool split = false;
+    bool check = false;
+    uint32_t seed = 0;
+
+    for (int i = 0; i < argc; ++i) {
+        if (strcmp(argv[i], "--games") == 0 && i + 1 < argc) {
+            games = strtoull(argv[++i], nullptr, 10);
+        } else if (strcmp(argv[i], "--seconds") == 0 && i + 1 < argc) {
+            seconds = atof(argv[++i]);
+        } else if (strcmp(argv[i], "--horizon") == 0 && i + 1 < argc) {
+            horizon = atof(argv[++i]);
+        } else if (strcmp(argv[i], "--threads") == 0 && i + 1 < argc) {
+            threads = size_t(strtoul(argv[++i], nullptr, 10));
+        } else if (strcmp(argv[i], "--split") == 0) {
+            split = true;
+        } else if (strcmp(argv[i], "--check") == 0) {
+            check = true;
+        } else if (strcmp(argv[i], "--seed") == 0 && i + 1 < argc) {
+            seed = uint32_t(strtoul(argv[++i], nullptr, 10));
+        } else {
+            printUsage();
+            return 1;
+        }
+    }
+    SimConfig config;
+    uint64_t ticks = uint64_t(seconds * config.tickRate);
+    if (games == 0 || ticks == 0 || !(horizon > 0.0)) {
+        printUsage();
+        return 1;
+    }
+
+    WorkPool pool(threads);
+    size_t splitTasks = 2 * pool.threadCount();
+    auto splitOnPool = [&pool](size_t count, const std::function<void(size_t)>& body) {
+        for (size_t i = 0; i < count; ++i) {
+            pool.submit([&body, i] { body(i); });
+        }
+        pool.wait();
+    };
+
+    std::vector<SearchGame> results(static_cast<size_t>(games));
+    auto start = std::chrono::steady_clock::now();
+    if (split) {
+        SearchBot bot(horizon);
+        bot.setParallel(splitOnPool, splitTasks);
+        for (size_t g = 0; g < results.size(); ++g) {
+            playSearchGame(bot, seed + uint32_t(g), ticks, check && g == 0, results[g]);
+        }
+    } else {
+        for (size_t g = 0; g < results.size(); ++g) {
+            pool.submit([&, g] {
+                SearchBot bot(horizon);
+                playSearchGame(bot, seed + uint32_t(g), ticks, check && g == 0, results[g]);
+            });
+        }
+        pool.wait();
+    }
+    double wallSeconds = secondsSince(start);
+
+    bool matched = true;
+    if (check) {
+        // The first game again, searched the other way
+        SearchBot bot(horizon);
+        if (!split) {
+            bot.setParallel(splitOnPool, splitTasks);
+        }
+        SearchGame other;
+        playSearchGame(bot, seed, ticks, true, other);
+        matched = other.inputs == results[0].inputs;
+    }
+
+    SearchStats stats;
+    uint64_t collisions = 0;
+    uint64_t cleanGames = 0;
+    double searchSeconds = 0.0;
+    double slowest = 0.0;
+    for (const auto &game : results) {
+        stats.decisions += game.stats.decisions;
+        stats.nodes += game.stats.nodes;
+        stats.updates += game.stats.updates;
+        stats.memoHits += game.stats.memoHits;
+        collisions += game.collisions;
+        cleanGames += game.collisions == 0;
+        searchSeconds += game.searchSeconds;
+        slowest = game.slowestDecision > slowest ? game.slowestDecision : slowest;
+    }
+    double playMinutes = double(games) * seconds / 60.0;
+    printf("games:        %llu x %.0f s, %.1f s horizon, %zu threads, %s\n", (unsigned long long)games,
+           seconds, horizon, pool.threadCount(), split ? "each search split" : "one game per thread");
+    printf("wall time:    %.3f s, %.0f games/minute\n", wallSeconds,
+           wallSeconds > 0.0 ? double(games) * 60.0 / wallSeconds : 0.0);
+    printf("collisions:   %llu (%.2f per minute of play), %llu games without one\n",
+           (unsigned long long)collisions, collisions / playMinutes, (unsigned long long)cleanGames);
+    printf("search:       %llu decisions, %llu nodes, %llu updates, %.1f%% memo hits\n",
+           (unsigned long long)stats.decisions, (unsigned long long)stats.nodes,
+           (unsigned long long)stats.updates,
+           stats.nodes + stats.memoHits > 0
+               ? 100.0 * double(stats.memoHits) / double(stats.nodes + stats.memoHits)
+               : 0.0);
+    printf("nodes/second: %.0f (%.0f updates/second)\n",
+           wallSeconds > 0.0 ? double(stats.nodes) / wallSeconds : 0.0,
+           wallSeconds > 0.0 ? double(stats.updates) / wallSeconds : 0.0);
+    printf("per decision: %.2f us average, %.3f ms slowest (tick budget %.3f ms)\n",
+           stats.decisions > 0 ? searchSeconds * 1e6 / double(stats.decisions) : 0.0, slowest * 1e3,
+           1e3 / config.tickRate);
+    if (check) {
+        printf("check:        %s\n", matched ? "split and serial searches decide the same" : "MISMATCH");
+    }
+    return matched ? 0 : 1;
+}
+
+int main(int argc, char** argv) {
+    if (argc < 2) {
+        return runCommand(0, nullptr, false);
+    }
+    if (strcmp(argv[1], "run") == 0) {
+        return runCommand(argc - 2, argv + 2, false);
+    }
+    if (strcmp(argv[1], "record") == 0) {
+        return runCommand(argc - 2, argv + 2, true);
+    }
+    if (strcmp(argv[1], "replay") == 0) {
+        return replayCommand(argc - 2, argv + 2);
+    }
+    if (strcmp(argv[1], "compare") == 0) {
+        return compareCommand(argc - 2, argv + 2);
+    }
+    if (strcmp(argv[1], "batch") == 0) {
+        return batchCommand(argc - 2, argv + 2);
+    }
+    if (strcmp(argv[1], "collide-bench") == 0) {
+        return collideBenchCommand(argc - 2, argv + 2);
+    }
+    if (strcmp(argv[1], "course") == 0) {
+        return courseCommand(argc - 2, argv + 2);
+    }
+    if (strcmp(argv[1], "course-file") == 0) {
+        return courseFileCommand(argc - 2, argv + 2);
+    }
+    if (strcmp(argv[1], "rewind") == 0) {
+        return rewindCommand(argc - 2, argv + 2);
+    }
+    if (strcmp(argv[1], "snapshot-bench") == 0) {
+        return snapshotBenchCommand(argc - 2, argv + 2);
+    }
+    if (strcmp(argv[1], "verify") == 0) {
+        return verifyCommand(argc - 2, argv + 2);
+    }
+    if (strcmp(argv[1], "submit") == 0) {
+        return submitCommand(argc - 2, argv + 2);
+    }
+    if (strcmp(argv[1], "gym-bench") == 0) {
+        return gymBenchCommand(argc - 2, argv + 2);
+    }
+    if (strcmp(argv[1], "search-bot") == 0) {
+        return searchBotCommand(argc - 2, argv + 2);
+    }
+    printUsage();
+    return 1;
+}
@@ -1,15 +1,26 @@
 #include <emscripten/emscripten.h>
 #include <emscripten/html5.h>
-#include <GLES2/gl2.h>
-#include <cmath>
-#include <vector>
+#include <GLES3/gl3.h>
 #include <cstdio>
-#include <algorithm> // For std::remove_if
+#include <memory>
+#include <vector>
+
+#include "course_file.h"
+#include "gl_state.h"
+#include "gl_stats.h"
+#include "profiler.h"
+#include "replay.h"
+#include "rewind.h"
+#include "search_bot.h"
+#include "sim.h"
+#include "trace.h"
+#include "world_batch.h"
 
 // ------------------------------------------------------
 // Explicit WebGL Context Initialization
 // ------------------------------------------------------
 EMSCRIPTEN_WEBGL_CONTEXT_HANDLE context;
+static int contextVersion = 0; // WebGL major version of the created context
 
 void initContext() {
     EmscriptenWebGLContextAttributes attr;
@@ -29,6 +40,7 @@ void initContext() {
     } else {
         printf("WebGL context created successfully.\n");
         emscripten_webgl_make_context_current(context);
+        contextVersion = attr.majorVersion;
     }
 }
 
@@ -55,6 +67,32 @@ void main() {
 }
 )";
 
+// ------------------------------------------------------
+// Shader sources for instanced spikes: the offset and color come from
+// per-instance attributes so all spikes are drawn with a single call.
+// GLSL ES 1.00 so the same program serves WebGL2 and ANGLE_instanced_arrays.
+// ------------------------------------------------------
+const char* instancedVertexShaderSource = R"(
+attribute vec2 aPosition;
+attribute vec2 aInstanceOffset;
+attribute vec4 aInstanceColor;
+uniform vec2 uScale;
+varying vec4 vColor;
+void main() {
+    vec2 pos = aPosition * uScale + aInstanceOffset;
+    gl_Position = vec4(pos, 0.0, 1.0);
+    vColor = aInstanceColor;
+}
+)";
+
+const char* instancedFragmentShaderSource = R"(
+precision mediump float;
+varying vec4 vColor;
+void main() {
+    gl_FragColor = vColor;
+}
+)";
+
 // ------------------------------------------------------
 // Global variables for shaders and buffers
 // ------------------------------------------------------
@@ -67,29 +105,68 @@ static GLint uColorLoc = -1;
 static GLuint playerVBO = 0; // 2D quad for the player
 static GLuint spikeVBO = 0;  // 2D triangle for spikes
 
-// Player state
-static float playerY = 0.0f;        // Player vertical position
-static float playerVelocity = 0.0f; // Player vertical velocity
-static bool  isOnGround = true;
+// How spikes are submitted, depending on what the context supports
+enum InstancingMode {
+    INSTANCING_NONE,   // one draw call per spike
+    INSTANCING_ANGLE,  // WebGL1 with ANGLE_instanced_arrays
+    INSTANCING_WEBGL2  // core WebGL2 instancing
+};
+static InstancingMode instancingMode = INSTANCING_NONE;
+
+static GLuint instancedProgram = 0;
+static GLint aInstPositionLoc = -1;
+static GLint aInstOffsetLoc = -1;
+static GLint aInstColorLoc = -1;
+static GLint uInstScaleLoc = -1;
+
+// Per-instance attributes: offset (x, y) followed by color (r, g, b, a)
+static const int spikeInstanceFloats = 6;
+static GLuint spikeInstanceVBO = 0;
+static GLfloat spikeInstanceData[SimState::maxSpikes * spikeInstanceFloats];
+
+// Vertex array objects capturing each mesh's vertex layout (0 when VAOs
+// are unavailable and attributes are set up before every draw instead)
+static GLuint playerVAO = 0;
+static GLuint spikeVAO = 0;          // per-spike loop path
+static GLuint spikeInstancedVAO = 0; // instanced path
+
+// Simulation state and parameters
+static SimConfig simConfig;
+static SimState sim;
 
-// World scrolling variables
-static float scrollSpeed = 0.02f;      // Speed at which spikes move left
-static float spikeSpawnTimer = 0.0f;
-static float spikeSpawnInterval = 2.0f; // seconds between spawns
+// Designer course streamed in from the page (simConfig.courseFile points
+// here while one is open)
+static CourseFile streamedCourse;
 
-// Gravity and jump settings
-static const float gravity = -0.06f;
-static const float jumpVelocity = 0.02f;
+// Fixed-timestep loop settings
+static const int maxTicksPerFrame = 8;     // catch-up budget per rendered frame
+static const double maxFrameDelta = 0.25;  // clamp for very long frames (seconds)
 
 // Time tracking for updates
 static double lastFrameTime = 0.0;
-
-// Structure for spikes
-struct Spike {
-    float x;
-    float y;
-};
-static std::vector<Spike> spikes;
+static double tickAccumulator = 0.0;
+
+// Input gathered since the last tick, applied on the next one
+static uint32_t pendingInput = 0;
+
+// Replay recording and playback
+static ReplayRecorder recorder;
+static std::vector<uint8_t> recordingBytes; // serialized by stopRecording()
+static Replay loadedReplay;
+static ReplayPlayer replayPlayer;
+static bool replaying = false;
+
+// Rewind debugging: the history of the live game, and whether the game is
+// paused on a past tick of it
+static RewindHistory rewindHistory;
+static bool rewound = false;
+
+// Lookahead search bot playing the live game, if enabled, and its
+// decision times since the last report
+static std::unique_ptr<SearchBot> searchBot;
+static double searchBotMs = 0.0;
+static double searchBotSlowestMs = 0.0;
+static SearchStats searchBotReported;
 
 // ------------------------------------------------------
 // Compile a shader from source
@@ -124,6 +201,9 @@ GLuint createProgram(const char* vsSource, const char* fsSource) {
     GLuint prog = glCreateProgram();
     glAttachShader(prog, vs);
     glAttachShader(prog, fs);
+    // Every program takes its vertex positions from attribute 0, so that
+    // attribute can stay enabled across programs.
+    glBindAttribLocation(prog, 0, "aPosition");
     glLinkProgram(prog);
 
     GLint status;
@@ -141,12 +221,98 @@ GLuint createProgram(const char* vsSource, const char* fsSource) {
     return prog;
 }
 
+// ------------------------------------------------------
+// Mesh vertex layouts. With VAOs each layout is one bind; without them
+// the buffers and attributes are set up on every call (redundant calls
+// are still elided by the state cache).
+// ------------------------------------------------------
+void setupPlayerMesh() {
+    cachedBindBuffer(GL_ARRAY_BUFFER, playerVBO);
+    cachedEnableVertexAttribArray(aPositionLoc);
+    cachedVertexAttribPointer(aPositionLoc, 2, GL_FLOAT, GL_FALSE, 0, 0);
+}
+
+void setupSpikeMesh() {
+    cachedBindBuffer(GL_ARRAY_BUFFER, spikeVBO);
+    cachedEnableVertexAttribArray(aPositionLoc);
+    cachedVertexAttribPointer(aPositionLoc, 2, GL_FLOAT, GL_FALSE, 0, 0);
+}
+
+void setupSpikeInstancedMesh() {
+    GLsizei stride = spikeInstanceFloats * sizeof(GLfloat);
+    cachedBindBuffer(GL_ARRAY_BUFFER, spikeInstanceVBO);
+    cachedEnableVertexAttribArray(aInstOffsetLoc);
+    cachedVertexAttribPointer(aInstOffsetLoc, 2, GL_FLOAT, GL_FALSE, stride, (const void*)0);
+    cachedVertexAttribDivisor(aInstOffsetLoc, 1);
+    cachedEnableVertexAttribArray(aInstColorLoc);
+    cachedVertexAttribPointer(aInstColorLoc, 4, GL_FLOAT, GL_FALSE, stride, (const void*)(2 * sizeof(GLfloat)));
+    cachedVertexAttribDivisor(aInstColorLoc, 1);
+
+    // Shared spike triangle
+    cachedBindBuffer(GL_ARRAY_BUFFER, spikeVBO);
+    cachedEnableVertexAttribArray(aInstPositionLoc);
+    cachedVertexAttribPointer(aInstPositionLoc, 2, GL_FLOAT, GL_FALSE, 0, 0);
+}
+
+GLuint createVertexArray(void (*setup)()) {
+    GLuint vao = 0;
+    glGenVertexArrays(1, &vao);
+    cachedBindVertexArray(vao);
+    setup();
+    cachedBindVertexArray(0);
+    return vao;
+}
+
+// ------------------------------------------------------
+// Capture each mesh's layout in a VAO: core in WebGL2, through
+// OES_vertex_array_object in WebGL1 (Emscripten routes the gl*VertexArray
+// calls to the extension once it is enabled)
+// ------------------------------------------------------
+void initVertexArrays() {
+    bool supported = contextVersion >= 2 || emscripten_webgl_enable_OES_vertex_array_object(context);
+    if (!supported) {
+        printf("Vertex array objects unavailable, setting up attributes per draw.\n");
+        return;
+    }
+    playerVAO = createVertexArray(setupPlayerMesh);
+    spikeVAO = createVertexArray(setupSpikeMesh);
+    if (instancingMode != INSTANCING_NONE) {
+        spikeInstancedVAO = createVertexArray(setupSpikeInstancedMesh);
+    }
+    printf("Using vertex array objects.\n");
+}
+
+void bindPlayerMesh() {
+    if (playerVAO) {
+        cachedBindVertexArray(playerVAO);
+    } else {
+        setupPlayerMesh();
+    }
+}
+
+void bindSpikeMesh() {
+    if (spikeVAO) {
+        cachedBindVertexArray(spikeVAO);
+    } else {
+        setupSpikeMesh();
+    }
+}
+
+void bindSpikeInstancedMesh() {
+    if (spikeInstancedVAO) {
+        cachedBindVertexArray(spikeInstancedVAO);
+    } else {
+        setupSpikeInstancedMesh();
+    }
+}
+
 // ------------------------------------------------------
 // Initialize GL objects (VBOs, shaders, etc.)
 // ------------------------------------------------------
 void initGL() {
+    glCacheReset();
     program = createProgram(vertexShaderSource, fragmentShaderSource);
-    glUseProgram(program);
+    cachedUseProgram(program);
 
     // Retrieve attribute and uniform locations
     aPositionLoc = glGetAttribLocation(program, "aPosition");
@@ -164,7 +330,7 @@ void initGL() {
         -0.05f,  0.05f
     };
     glGenBuffers(1, &playerVBO);
-    glBindBuffer(GL_ARRAY_BUFFER, playerVBO);
+    cachedBindBuffer(GL_ARRAY_BUFFER, playerVBO);
     glBufferData(GL_ARRAY_BUFFER, sizeof(playerVertices), playerVertices, GL_STATIC_DRAW);
 
     // Define a spike as a triangle (isosceles)
@@ -174,9 +340,40 @@ void initGL() {
          0.0f,  0.1f
     };
     glGenBuffers(1, &spikeVBO);
-    glBindBuffer(GL_ARRAY_BUFFER, spikeVBO);
+    cachedBindBuffer(GL_ARRAY_BUFFER, spikeVBO);
     glBufferData(GL_ARRAY_BUFFER, sizeof(spikeVertices), spikeVertices, GL_STATIC_DRAW);
 
+    // Pick the spike instancing path
+    if (contextVersion >= 2) {
+        instancingMode = INSTANCING_WEBGL2;
+    } else if (emscripten_webgl_enable_ANGLE_instanced_arrays(context)) {
+        // Emscripten routes glDrawArraysInstanced/glVertexAttribDivisor
+        // to the extension once it is enabled.
+        instancingMode = INSTANCING_ANGLE;
+    }
+    if (instancingMode != INSTANCING_NONE) {
+        instancedProgram = createProgram(instancedVertexShaderSource, instancedFragmentShaderSource);
+        if (!instancedProgram) {
+            instancingMode = INSTANCING_NONE;
+        }
+    }
+    if (instancingMode != INSTANCING_NONE) {
+        aInstPositionLoc = glGetAttribLocation(instancedProgram, "aPosition");
+        aInstOffsetLoc = glGetAttribLocation(instancedProgram, "aInstanceOffset");
+        aInstColorLoc = glGetAttribLocation(instancedProgram, "aInstanceColor");
+        uInstScaleLoc = glGetUniformLocation(instancedProgram, "uScale");
+        glGenBuffers(1, &spikeInstanceVBO);
+        cachedBindBuffer(GL_ARRAY_BUFFER, spikeInstanceVBO);
+        glBufferData(GL_ARRAY_BUFFER, sizeof(spikeInstanceData), nullptr, GL_DYNAMIC_DRAW);
+        printf("Spike instancing: %s\n",
+               instancingMode == INSTANCING_WEBGL2 ? "WebGL2" : "ANGLE_instanced_arrays");
+    } else {
+        printf("Spike instancing unavailable, drawing spikes individually.\n");
+    }
+    cachedUseProgram(program);
+
+    initVertexArrays();
+
     // Set initial GL state
     glClearColor(0.5f, 0.5f, 0.5f, 1.0f);
     glEnable(GL_BLEND);
@@ -190,108 +387,577 @@ extern "C" {
 EMSCRIPTEN_KEEPALIVE
 void onKeyDown(int keyCode) {
     // Space key is typically keyCode 32
-    if (keyCode == 32) {
-        if (isOnGround) {
-            playerVelocity = jumpVelocity;
-            isOnGround = false;
+    // Keyboard input is ignored while a replay drives the game.
+    if (keyCode == 32 && !replaying && !rewound) {
+        pendingInput |= SIM_INPUT_JUMP;
+    }
+}
+}
+
+// ------------------------------------------------------
+// Change the simulation tick rate (ticks per second)
+// ------------------------------------------------------
+extern "C" {
+EMSCRIPTEN_KEEPALIVE
+void setSimTickRate(double ticksPerSecond) {
+    if (recorder.isRecording() || replaying) {
+        printf("Cannot change the tick rate while recording or replaying\n");
+        return;
+    }
+    if (ticksPerSecond > 0.0) {
+        simSetTickRate(sim, simConfig, ticksPerSecond);
+        tickAccumulator = 0.0;
+        // The history only replays under the config it was recorded with
+        rewindHistory.clear();
+    }
+}
+}
+
+// ------------------------------------------------------
+// Replay recording: startRecording() restarts the game and logs every
+// tick's input (and, with hashes != 0, a hash of the state every
+// replayHashInterval ticks for desync checks), returning 0 if it can't
+// record; stopRecording() serializes the log and returns its size, and
+// getRecordingData() returns a pointer to the bytes.
+// ------------------------------------------------------
+extern "C" {
+EMSCRIPTEN_KEEPALIVE
+int startRecording(int hashes) {
+    if (simConfig.courseFile) {
+        // Replays only record a seed, not the course itself
+        printf("Cannot record a streamed course\n");
+        return 0;
+    }
+    replaying = false;
+    rewound = false;
+    simInit(sim, simConfig);
+    pendingInput = 0;
+    tickAccumulator = 0.0;
+    recorder.begin(simConfig, hashes != 0 ? replayHashInterval : 0);
+    printf("Recording started (seed %u)\n", simConfig.seed);
+    return 1;
+}
+
+EMSCRIPTEN_KEEPALIVE
+int stopRecording() {
+    recorder.end();
+    replaySerialize(recorder.replay(), recordingBytes);
+    printf("Recording stopped: %llu ticks, %zu input events\n",
+           (unsigned long long)recorder.replay().tickCount, recorder.replay().events.size());
+    return int(recordingBytes.size());
+}
+
+EMSCRIPTEN_KEEPALIVE
+const uint8_t* getRecordingData() {
+    return recordingBytes.data();
+}
+}
+
+// ------------------------------------------------------
+// Replay playback: loadReplay() parses a serialized replay from wasm
+// memory; playReplay() restarts the game and either plays it in real time
+// or, with fast != 0, runs it to the end immediately without rendering.
+// ------------------------------------------------------
+extern "C" {
+EMSCRIPTEN_KEEPALIVE
+int loadReplay(const uint8_t* data, int size) {
+    return replayDeserialize(data, size_t(size), loadedReplay) ? 1 : 0;
+}
+
+EMSCRIPTEN_KEEPALIVE
+void playReplay(int fast) {
+    recorder.end();
+    rewound = false;
+    rewindHistory.clear();
+    simConfig = loadedReplay.config;
+    pendingInput = 0;
+    tickAccumulator = 0.0;
+    if (fast) {
+        replaying = false;
+        double start = emscripten_get_now();
+        std::vector<uint64_t> collisionTicks;
+        uint64_t collisions = replayRunFast(loadedReplay, sim, &collisionTicks);
+        double ms = emscripten_get_now() - start;
+        for (uint64_t tick : collisionTicks) {
+            printf("Replay collision at tick %llu\n", (unsigned long long)tick);
         }
+        printf("Replayed %llu ticks in %.2f ms (%llu collisions)\n",
+               (unsigned long long)loadedReplay.tickCount, ms, (unsigned long long)collisions);
+        sim.prevPlayerY = sim.playerY;
+    } else {
+        simInit(sim, simConfig);
+        replayPlayer.start(loadedReplay);
+        replaying = true;
+        printf("Replay started (%llu ticks)\n", (unsigned long long)loadedReplay.tickCount);
     }
 }
 }
 
 // ------------------------------------------------------
-// Update game logic: player physics, spike spawning/movement, collision
+// Course streaming: the page fetches a course file's header
+// (courseFileHeaderSize bytes) and then its index (courseIndexOffset() and
+// courseIndexBytes() give the range), and opens the course with both. It
+// then polls courseWantedChunk() and fetches each wanted chunk's byte range
+// for provideCourseChunk(). The game waits on the chunks it needs, so a
+// slow network stalls it rather than skipping obstacles. 64-bit offsets
+// are passed as doubles, which JavaScript numbers hold exactly up to 2^53.
 // ------------------------------------------------------
-void update(double currentTime) {
-    float deltaTime = float(currentTime - lastFrameTime);
-    lastFrameTime = currentTime;
+extern "C" {
+EMSCRIPTEN_KEEPALIVE
+double courseIndexOffset(const uint8_t* header, int size) {
+    uint64_t offset, bytes;
+    return courseFileIndexRange(header, size_t(size), offset, bytes) ? double(offset) : -1.0;
+}
 
-    // Update player physics (gravity and jump)
-    playerVelocity += gravity * deltaTime;
-    playerY += playerVelocity;
-    if (playerY < -0.4f) {
-        // Simulate ground collision
-        playerY = -0.4f;
-        playerVelocity = 0.0f;
-        isOnGround = true;
-    }
-
-    // Spawn spikes periodically
-    spikeSpawnTimer += deltaTime;
-    if (spikeSpawnTimer >= spikeSpawnInterval) {
-        spikeSpawnTimer = 0.0f;
-        // Spawn spike off-screen to the right
-        spikes.push_back({1.2f, -0.4f});
-    }
-
-    // Move spikes to the left
-    for (auto &spike : spikes) {
-        spike.x -= scrollSpeed * deltaTime * 60.0f;
-    }
-
-    // Remove spikes that have gone off-screen to the left
-    spikes.erase(
-        std::remove_if(spikes.begin(), spikes.end(),
-            [](const Spike &s){ return s.x < -1.2f; }),
-        spikes.end()
-    );
-
-    // Check collisions (using simple bounding boxes)
-    for (auto &spike : spikes) {
-        float spikeWidth = 0.05f;  // half-width approximation
-        float spikeHeight = 0.1f;  // half-height from base to tip
-
-        bool collisionX = (fabs(spike.x - 0.0f) < (spikeWidth + 0.05f));
-        bool collisionY = (fabs(spike.y - playerY) < (spikeHeight + 0.05f));
-
-        if (collisionX && collisionY) {
-            // Collision: reset player state and clear spikes
-            playerY = -0.4f;
-            playerVelocity = 0.0f;
-            isOnGround = true;
-            spikes.clear();
-            printf("Collision! Resetting...\n");
-            break;
+EMSCRIPTEN_KEEPALIVE
+double courseIndexBytes(const uint8_t* header, int size) {
+    uint64_t offset, bytes;
+    return courseFileIndexRange(header, size_t(size), offset, bytes) ? double(bytes) : -1.0;
+}
+
+EMSCRIPTEN_KEEPALIVE
+int openCourseStream(const uint8_t* header, int headerSize, const uint8_t* index, int indexSize) {
+    recorder.end();
+    replaying = false;
+    rewound = false;
+    simConfig.courseFile = nullptr;
+    if (!streamedCourse.openStream(header, size_t(headerSize), index, size_t(indexSize))) {
+        simInit(sim, simConfig);
+        return 0;
+    }
+    simConfig.courseFile = &streamedCourse;
+    simInit(sim, simConfig);
+    pendingInput = 0;
+    tickAccumulator = 0.0;
+    printf("Streaming a course of %llu obstacles in %llu chunks\n",
+           (unsigned long long)streamedCourse.obstacleCount(),
+           (unsigned long long)streamedCourse.chunkCount());
+    return 1;
+}
+
+// The chunk the game needs next (the current one, then the one after), or
+// -1 if it has both
+EMSCRIPTEN_KEEPALIVE
+double courseWantedChunk() {
+    if (!simConfig.courseFile) {
+        return -1.0;
+    }
+    uint64_t chunk = sim.course.next / courseChunkSize;
+    for (uint64_t c = chunk; c <= chunk + 1; ++c) {
+        if (sim.course.chunkIds[c & 1] != c && !streamedCourse.hasChunk(c)) {
+            return double(c);
         }
     }
+    return -1.0;
+}
+
+// Byte range of a chunk within the file
+EMSCRIPTEN_KEEPALIVE
+double courseChunkOffset(double chunk) {
+    if (chunk < 0.0 || uint64_t(chunk) >= streamedCourse.chunkCount()) {
+        return -1.0;
+    }
+    return double(streamedCourse.chunkOffset(uint64_t(chunk)));
+}
+
+EMSCRIPTEN_KEEPALIVE
+double courseChunkBytes(double chunk) {
+    if (chunk < 0.0 || uint64_t(chunk) >= streamedCourse.chunkCount()) {
+        return -1.0;
+    }
+    return double(streamedCourse.chunkSize(uint64_t(chunk)));
+}
+
+EMSCRIPTEN_KEEPALIVE
+void provideCourseChunk(double chunk, const uint8_t* data, int size) {
+    streamedCourse.provideChunk(uint64_t(chunk), data, size_t(size));
+}
+}
+
+// ------------------------------------------------------
+// Rewind debugging: enableRewind() keeps a history of the last `seconds`
+// of play (0 turns it off). rewindStep() pauses the game and moves it
+// `ticks` ticks backwards (negative) or forwards through the history,
+// rebuilding each state from the nearest keyframe, and rewindResume()
+// plays on from the tick shown, dropping the history after it.
+// ------------------------------------------------------
+extern "C" {
+EMSCRIPTEN_KEEPALIVE
+void enableRewind(double seconds) {
+    rewound = false;
+    uint64_t ticks = seconds > 0.0 ? uint64_t(seconds * simConfig.tickRate) : 0;
+    rewindHistory.reset(ticks, uint32_t(simConfig.tickRate / 2.0 + 0.5));
+    if (ticks > 0) {
+        printf("Rewind history: %.0f s, %.1f KB (%.1f KB per minute)\n", seconds,
+               double(rewindHistory.memoryBytes()) / 1024.0,
+               rewindHistory.bytesPerMinute(simConfig.tickRate) / 1024.0);
+    }
+}
+
+EMSCRIPTEN_KEEPALIVE
+void rewindStep(int ticks) {
+    if (!rewindHistory.isEnabled() || recorder.isRecording() || replaying ||
+        simConfig.courseFile) {
+        printf("Rewind needs the history enabled, a seeded course, and no recording or replay\n");
+        return;
+    }
+    uint64_t first = rewindHistory.firstTick();
+    uint64_t last = rewindHistory.endTick();
+    int64_t target = int64_t(sim.tick) + ticks;
+    target = target < int64_t(first) ? int64_t(first) : target;
+    target = target > int64_t(last) ? int64_t(last) : target;
+    if (!rewindHistory.seek(uint64_t(target), simConfig, sim)) {
+        return;
+    }
+    rewound = true;
+    pendingInput = 0;
+    tickAccumulator = 0.0;
+    printf("Tick %llu (history %llu to %llu): playerY %.6f, %s, %zu spikes%s\n",
+           (unsigned long long)sim.tick, (unsigned long long)first, (unsigned long long)last,
+           sim.playerY, sim.isOnGround ? "on ground" : "in air", sim.spikes.size(),
+           sim.tick < last && (rewindHistory.inputAt(sim.tick) & SIM_INPUT_JUMP) ? ", jumps" : "");
+}
+
+EMSCRIPTEN_KEEPALIVE
+void rewindResume() {
+    if (rewound) {
+        rewindHistory.truncate(sim.tick);
+        rewound = false;
+    }
+}
+}
+
+// ------------------------------------------------------
+// Let the lookahead search bot (search_bot.h) play, searching
+// `horizonSeconds` ahead every tick; 0 hands the game back. It reports
+// its decision times and search rate every 600 decisions.
+// ------------------------------------------------------
+extern "C" {
+EMSCRIPTEN_KEEPALIVE
+void enableSearchBot(double horizonSeconds) {
+    if (horizonSeconds <= 0.0) {
+        searchBot.reset();
+        return;
+    }
+    searchBot.reset(new SearchBot(horizonSeconds));
+    searchBotMs = 0.0;
+    searchBotSlowestMs = 0.0;
+    searchBotReported = SearchStats();
+    printf("Search bot playing, %.1f s horizon\n", horizonSeconds);
+}
+}
+
+// Ask the search bot for this tick's input, reporting now and then
+static uint32_t searchBotInput() {
+    double start = emscripten_get_now();
+    uint32_t input = searchBot->decide(sim, simConfig);
+    double ms = emscripten_get_now() - start;
+    searchBotMs += ms;
+    searchBotSlowestMs = ms > searchBotSlowestMs ? ms : searchBotSlowestMs;
+
+    const SearchStats& stats = searchBot->stats();
+    uint64_t decisions = stats.decisions - searchBotReported.decisions;
+    if (decisions >= 600) {
+        uint64_t nodes = stats.nodes - searchBotReported.nodes;
+        printf("Search bot: %.1f us per decision (slowest %.2f ms), %.0f nodes/s\n",
+               searchBotMs * 1000.0 / double(decisions), searchBotSlowestMs,
+               searchBotMs > 0.0 ? double(nodes) * 1000.0 / searchBotMs : 0.0);
+        searchBotMs = 0.0;
+        searchBotSlowestMs = 0.0;
+        searchBotReported = stats;
+    }
+    return input;
+}
+
+// ------------------------------------------------------
+// Benchmark the SoA world batch kernel (wasm simd128) from the page:
+// steps `worlds` games for `ticks` ticks and prints worlds*ticks/second.
+// ------------------------------------------------------
+extern "C" {
+EMSCRIPTEN_KEEPALIVE
+double benchWorldBatch(int worlds, int ticks) {
+    if (worlds <= 0 || ticks <= 0) {
+        return 0.0;
+    }
+    WorldBatch batch;
+    batch.init(size_t(worlds), simConfig);
+    std::vector<uint8_t> inputs(size_t(worlds), 0);
+    std::vector<uint8_t> collided(size_t(worlds), 0);
+
+    double start = emscripten_get_now();
+    for (int t = 0; t < ticks; ++t) {
+        // Every world jumps periodically, staggered so the worlds diverge
+        for (int w = 0; w < worlds; ++w) {
+            inputs[w] = ((t + w) % 97 == 0) ? SIM_INPUT_JUMP : 0;
+        }
+        batch.step(inputs.data(), collided.data());
+    }
+    double seconds = (emscripten_get_now() - start) / 1000.0;
+    double rate = seconds > 0.0 ? double(worlds) * ticks / seconds : 0.0;
+    printf("World batch: %d worlds x %d ticks in %.3f s (%.0f worlds*ticks/s)\n",
+           worlds, ticks, seconds, rate);
+    return rate;
+}
+}
+
+// ------------------------------------------------------
+// Advance the game by one fixed tick
+// ------------------------------------------------------
+void update() {
+    uint32_t input = pendingInput;
+    pendingInput = 0;
+    if (replaying) {
+        if (replayPlayer.finished(sim.tick)) {
+            replaying = false;
+            printf("Replay finished at tick %llu\n", (unsigned long long)sim.tick);
+        } else {
+            input = replayPlayer.inputForTick(sim.tick);
+        }
+    }
+    // The bot only plays seeded courses: a streamed course file may not
+    // have the chunks its search looks ahead into
+    if (searchBot && !replaying && !simConfig.courseFile) {
+        input |= searchBotInput();
+    }
+    if (recorder.isRecording()) {
+        recorder.recordTick(sim.tick, input);
+    }
+    if (!simConfig.courseFile) {
+        rewindHistory.record(sim, input);
+    }
+
+    if (simUpdate(sim, simConfig, input)) {
+        printf("Collision at tick %llu! Resetting...\n", (unsigned long long)(sim.tick - 1));
+    }
+    // Hash the state the tick left, for desync checks against other builds
+    recorder.recordState(sim);
+}
+
+// ------------------------------------------------------
+// Draw every spike with one instanced draw call
+// ------------------------------------------------------
+void renderSpikesInstanced(float spikeOffset) {
+    GLsizei count = GLsizei(sim.spikes.size());
+    if (count == 0) {
+        return;
+    }
+
+    // Fill the per-instance attributes: offset then color (white)
+    GLfloat* out = spikeInstanceData;
+    for (auto &spike : sim.spikes) {
+        out[0] = spike.x + spikeOffset;
+        out[1] = spike.y;
+        out[2] = 1.0f;
+        out[3] = 1.0f;
+        out[4] = 1.0f;
+        out[5] = 1.0f;
+        out += spikeInstanceFloats;
+    }
+
+    // Upload into the buffer preallocated for maxSpikes instances
+    GLsizeiptr bytes = GLsizeiptr(count) * spikeInstanceFloats * sizeof(GLfloat);
+    cachedBindBuffer(GL_ARRAY_BUFFER, spikeInstanceVBO);
+    countedBufferSubData(GL_ARRAY_BUFFER, 0, bytes, spikeInstanceData);
+
+    bindSpikeInstancedMesh();
+    cachedUseProgram(instancedProgram);
+    cachedUniform2f(uInstScaleLoc, 1.0f, 1.0f);
+    countedDrawArraysInstanced(GL_TRIANGLES, 0, 3, count);
+
+    // Without VAOs the per-instance attributes stay enabled: the flat
+    // program doesn't read them, and attribute 0 (positions, divisor 0) is
+    // shared by both programs, so leaving them set up saves re-specifying
+    // them next frame.
 }
 
 // ------------------------------------------------------
-// Render the scene: draw player and spikes
+// Render the scene: draw player and spikes.
+// alpha is the fraction of a tick elapsed since the last update, used to
+// interpolate between the previous and current simulation states.
 // ------------------------------------------------------
-void render() {
-    glClear(GL_COLOR_BUFFER_BIT);
-    glUseProgram(program);
+void render(float alpha) {
+    TRACE_SCOPE("render");
+
+    // Spikes move a constant distance per tick, so their previous position
+    // is one step to the right of the current one.
+    float spikeOffset = simSpikeStep(simConfig) * (1.0f - alpha);
+    float drawPlayerY = sim.prevPlayerY + (sim.playerY - sim.prevPlayerY) * alpha;
+
+    countedClear(GL_COLOR_BUFFER_BIT);
+    cachedUseProgram(program);
 
     // Draw the player (a square)
-    glBindBuffer(GL_ARRAY_BUFFER, playerVBO);
-    glEnableVertexAttribArray(aPositionLoc);
-    glVertexAttribPointer(aPositionLoc, 2, GL_FLOAT, GL_FALSE, 0, 0);
-    // Player remains at x=0, with y position varying
-    glUniform2f(uTranslationLoc, 0.0f, playerY);
-    glUniform2f(uScaleLoc, 1.0f, 1.0f);
-    glUniform4f(uColorLoc, 0.0f, 0.0f, 0.0f, 1.0f); // Black color for player
-    glDrawArrays(GL_TRIANGLES, 0, 6);
+    {
+        TRACE_SCOPE("draw player");
+        bindPlayerMesh();
+        // Player remains at x=0, with y position varying
+        cachedUniform2f(uTranslationLoc, 0.0f, drawPlayerY);
+        cachedUniform2f(uScaleLoc, 1.0f, 1.0f);
+        cachedUniform4f(uColorLoc, 0.0f, 0.0f, 0.0f, 1.0f); // Black color for player
+        countedDrawArrays(GL_TRIANGLES, 0, 6);
+    }
 
     // Draw spikes
-    glBindBuffer(GL_ARRAY_BUFFER, spikeVBO);
-    glVertexAttribPointer(aPositionLoc, 2, GL_FLOAT, GL_FALSE, 0, 0);
-    glUniform2f(uScaleLoc, 1.0f, 1.0f);
-    glUniform4f(uColorLoc, 1.0f, 1.0f, 1.0f, 1.0f); // White color for spikes
-    for (auto &spike : spikes) {
-        glUniform2f(uTranslationLoc, spike.x, spike.y);
-        glDrawArrays(GL_TRIANGLES, 0, 3);
+    TRACE_SCOPE("draw spikes");
+    if (instancingMode != INSTANCING_NONE) {
+        renderSpikesInstanced(spikeOffset);
+    } else {
+        bindSpikeMesh();
+        cachedUniform2f(uScaleLoc, 1.0f, 1.0f);
+        cachedUniform4f(uColorLoc, 1.0f, 1.0f, 1.0f, 1.0f); // White color for spikes
+        for (auto &spike : sim.spikes) {
+            cachedUniform2f(uTranslationLoc, spike.x + spikeOffset, spike.y);
+            countedDrawArrays(GL_TRIANGLES, 0, 3);
+        }
+    }
+}
+
+#ifdef GL_STATS
+// ------------------------------------------------------
+// GL stats overlay: a bar chart in the top-left corner with one bar per
+// frame of the rolling window (newest on the right). Yellow is the total
+// number of GL calls, red the draw calls. Drawn after the frame's stats
+// are closed; its own calls are discarded so they don't show up in them.
+// ------------------------------------------------------
+void renderStatsOverlay() {
+    const float left = -0.95f, right = -0.35f, bottom = 0.6f, height = 0.3f;
+    const float barWidth = (right - left) / glStatsWindow;
+    const float quadSize = 0.1f; // the player quad is 0.1 x 0.1
+
+    uint32_t peak = 1;
+    GLFrameStats frame;
+    for (int age = 0; glStatsFrame(age, frame); ++age) {
+        if (frame.glCalls > peak) {
+            peak = frame.glCalls;
+        }
+    }
+
+    cachedUseProgram(program);
+    bindPlayerMesh();
+    for (int age = 0; glStatsFrame(age, frame); ++age) {
+        float x = right - (age + 0.5f) * barWidth;
+        float callsHeight = height * frame.glCalls / peak;
+        float drawHeight = height * frame.drawCalls / peak;
+
+        cachedUniform4f(uColorLoc, 1.0f, 0.85f, 0.2f, 0.8f);
+        cachedUniform2f(uScaleLoc, barWidth / quadSize, callsHeight / quadSize);
+        cachedUniform2f(uTranslationLoc, x, bottom + callsHeight * 0.5f);
+        countedDrawArrays(GL_TRIANGLES, 0, 6);
+
+        cachedUniform4f(uColorLoc, 0.9f, 0.1f, 0.1f, 0.9f);
+        cachedUniform2f(uScaleLoc, barWidth / quadSize, drawHeight / quadSize);
+        cachedUniform2f(uTranslationLoc, x, bottom + drawHeight * 0.5f);
+        countedDrawArrays(GL_TRIANGLES, 0, 6);
     }
-    glDisableVertexAttribArray(aPositionLoc);
+    glStatsCurrent = GLFrameStats();
+}
+
+// ------------------------------------------------------
+// Rolling-window GL stats as JSON (debug builds only)
+// ------------------------------------------------------
+extern "C" {
+EMSCRIPTEN_KEEPALIVE
+const char* getGLStats() {
+    return glStatsJSON();
+}
+}
+#endif
+
+// ------------------------------------------------------
+// Frame-phase timing percentiles and the frame interval histogram as
+// JSON, for scraping from the page (see profiler.h)
+// ------------------------------------------------------
+extern "C" {
+EMSCRIPTEN_KEEPALIVE
+const char* getFrameStatsJSON() {
+    return profilerJSON();
+}
+}
+
+#ifdef TRACING
+// ------------------------------------------------------
+// Recorded trace zones as Chrome trace_event JSON (TRACING builds only).
+// The returned string is valid until the next call.
+// ------------------------------------------------------
+extern "C" {
+EMSCRIPTEN_KEEPALIVE
+const char* getTraceJSON() {
+    static std::string json;
+    traceExportJSON(json);
+    return json.c_str();
 }
+}
+#endif
 
 // ------------------------------------------------------
-// Main loop called by Emscripten's requestAnimationFrame
+// Main loop called by Emscripten's requestAnimationFrame.
+// Real time is accumulated and consumed in fixed simulation ticks; rendering
+// happens once per frame, interpolated between the last two ticks.
 // ------------------------------------------------------
 void mainLoop() {
-    double currentTime = emscripten_get_now() / 1000.0; // Convert ms to seconds
-    update(currentTime);
-    render();
+    TRACE_SCOPE("frame");
+    double frameStartMs = emscripten_get_now();
+    double currentTime = frameStartMs / 1000.0; // Convert ms to seconds
+    double frameDelta = currentTime - lastFrameTime;
+    lastFrameTime = currentTime;
+    profilerRecord(PROFILE_INTERVAL, frameDelta * 1000.0);
+
+    // A throttled tab or long pause can produce huge deltas; clamp them so a
+    // single frame never tries to simulate minutes of game time.
+    if (frameDelta > maxFrameDelta) {
+        frameDelta = maxFrameDelta;
+    }
+    tickAccumulator += frameDelta;
+
+    // Run as many ticks as are due. If we fall behind, the remaining time
+    // stays in the accumulator and is caught up on the following frames, so
+    // brief stalls drop rendered frames rather than simulation ticks.
+    double tickDelta = 1.0 / simConfig.tickRate;
+    int ticks = 0;
+    double updateStartMs = emscripten_get_now();
+    // A streamed course still waiting for a chunk holds the game, with no
+    // backlog to catch up on once it arrives; so does rewinding.
+    if (rewound || !simPrefetchCourse(sim, simConfig)) {
+        tickAccumulator = 0.0;
+    }
+    while (tickAccumulator >= tickDelta && ticks < maxTicksPerFrame) {
+        update();
+        tickAccumulator -= tickDelta;
+        ++ticks;
+    }
+    // A machine that can't keep up even at maxTicksPerFrame would grow the
+    // backlog without end and never catch up (the "spiral of death"). Carry
+    // at most one frame's budget over instead: the game then runs slower
+    // than real time, which is accepted.
+    double maxBacklog = maxTicksPerFrame * tickDelta;
+    if (tickAccumulator > maxBacklog) {
+        tickAccumulator = maxBacklog;
+    }
+    // Frames that ran no ticks (high refresh rates) would only skew the
+    // update percentiles towards zero, so they aren't recorded.
+    if (ticks > 0) {
+        profilerRecord(PROFILE_UPDATE, emscripten_get_now() - updateStartMs);
+    }
+
+    // Generate the course's next chunk now rather than on the tick that
+    // reaches it
+    simPrefetchCourse(sim, simConfig);
+
+    // A rewound game shows exactly the state it was rebuilt to
+    float alpha = rewound ? 1.0f : float(tickAccumulator / tickDelta);
+    if (alpha > 1.0f) {
+        alpha = 1.0f;
+    }
+    double renderStartMs = emscripten_get_now();
+    render(alpha);
+    double renderEndMs = emscripten_get_now();
+    profilerRecord(PROFILE_RENDER, renderEndMs - renderStartMs);
+    profilerRecord(PROFILE_FRAME, renderEndMs - frameStartMs);
+
+    glStatsEndFrame();
+#ifdef GL_STATS
+    renderStatsOverlay();
+#endif
 }
 
 // ------------------------------------------------------
@@ -304,7 +970,10 @@ int main() {
     // Then initialize shaders, buffers, and other GL state
     initGL();
 
+    simInit(sim, simConfig);
+
     // Start the main loop using the browser's requestAnimationFrame
+    lastFrameTime = emscripten_get_now() / 1000.0;
     emscripten_set_main_loop(mainLoop, 0, 1);
     return 0;
 }
@@ -0,0 +1,79 @@
+#include "profiler.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <cstdio>
+
+static const char* phaseNames[PROFILE_PHASE_COUNT] = {"update", "render", "frame", "interval"};
+
+// Single-producer ring of samples. `written` counts every sample ever
+// recorded; the writer stores the sample before publishing the new count.
+struct SampleRing {
+    float samples[profileWindow];
+    std::atomic<uint32_t> written;
+};
+
+static SampleRing rings[PROFILE_PHASE_COUNT];
+static std::atomic<uint32_t> histogram[profileHistogramBuckets];
+
+static char jsonBuffer[4096];
+
+void profilerRecord(ProfilePhase phase, double ms) {
+    SampleRing& ring = rings[phase];
+    uint32_t n = ring.written.load(std::memory_order_relaxed);
+    ring.samples[n % profileWindow] = float(ms);
+    ring.written.store(n + 1, std::memory_order_release);
+
+    if (phase == PROFILE_INTERVAL) {
+        int bucket = ms < 0.0 ? 0 : int(ms);
+        bucket = std::min(bucket, profileHistogramBuckets - 1);
+        histogram[bucket].fetch_add(1, std::memory_order_relaxed);
+    }
+}
+
+// ------------------------------------------------------
+// Percentiles over a snapshot of the window
+// ------------------------------------------------------
+ProfileSummary profilerSummary(ProfilePhase phase) {
+    const SampleRing& ring = rings[phase];
+    uint32_t written = ring.written.load(std::memory_order_acquire);
+    int count = int(std::min<uint32_t>(written, profileWindow));
+
+    float sorted[profileWindow];
+    for (int i = 0; i < count; ++i) {
+        sorted[i] = ring.samples[(written - 1 - i) % profileWindow];
+    }
+    std::sort(sorted, sorted + count);
+
+    ProfileSummary summary = {count, 0.0, 0.0, 0.0, 0.0};
+    if (count > 0) {
+        auto percentile = [&](double p) {
+            int index = int(p * (count - 1) + 0.5);
+            return double(sorted[index]);
+        };
+        summary.p50 = percentile(0.50);
+        summary.p95 = percentile(0.95);
+        summary.p99 = percentile(0.99);
+        summary.max = sorted[count - 1];
+    }
+    return summary;
+}
+
+const char* profilerJSON() {
+    int len = snprintf(jsonBuffer, sizeof(jsonBuffer), "{");
+    for (int phase = 0; phase < PROFILE_PHASE_COUNT; ++phase) {
+        ProfileSummary s = profilerSummary(ProfilePhase(phase));
+        len += snprintf(jsonBuffer + len, sizeof(jsonBuffer) - len,
+                        "\"%s\":{\"count\":%d,\"p50\":%.3f,\"p95\":%.3f,\"p99\":%.3f,\"max\":%.3f},",
+                        phaseNames[phase], s.count, s.p50, s.p95, s.p99, s.max);
+    }
+    len += snprintf(jsonBuffer + len, sizeof(jsonBuffer) - len,
+                    "\"intervalHistogram\":{\"bucketMs\":1,\"counts\":[");
+    for (int i = 0; i < profileHistogramBuckets; ++i) {
+        len += snprintf(jsonBuffer + len, sizeof(jsonBuffer) - len, "%s%u", i ? "," : "",
+                        histogram[i].load(std::memory_order_relaxed));
+    }
+    snprintf(jsonBuffer + len, sizeof(jsonBuffer) - len, "]}}");
+    return jsonBuffer;
+}
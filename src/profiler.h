@@ -0,0 +1,40 @@
+#pragma once
+
+// ------------------------------------------------------
+// Frame-phase profiler.
+// Durations (in milliseconds, measured by the caller) are pushed into a
+// fixed-size ring per phase. Each ring has a single writer and publishes
+// its write position with an atomic store, so readers never block it.
+// Summaries report p50/p95/p99/max over the most recent samples, plus a
+// histogram of frame intervals since startup.
+// ------------------------------------------------------
+
+enum ProfilePhase {
+    PROFILE_UPDATE,    // all simulation ticks run in one frame
+    PROFILE_RENDER,    // render()
+    PROFILE_FRAME,     // the whole mainLoop() call
+    PROFILE_INTERVAL,  // time between consecutive frames
+    PROFILE_PHASE_COUNT
+};
+
+// Samples kept per phase for the percentiles
+static const int profileWindow = 1024;
+
+// Frame interval histogram: 1 ms buckets, the last one collects everything slower
+static const int profileHistogramBuckets = 51;
+
+struct ProfileSummary {
+    int count;      // samples in the window
+    double p50;
+    double p95;
+    double p99;
+    double max;
+};
+
+void profilerRecord(ProfilePhase phase, double ms);
+
+ProfileSummary profilerSummary(ProfilePhase phase);
+
+// All phases and the interval histogram as JSON. The returned string is
+// valid until the next call.
+const char* profilerJSON();
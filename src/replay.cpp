@@ -0,0 +1,510 @@
+#include "replay.h"
+
+#include <cstdio>
+#include <cstring>
+
+#include "byte_io.h"
+#include "fast_forward.h"
+
+// File layout (version 2), all values little-endian:
+//   "BGRP" magic, u32 version
+//   config: f64 tickRate, f32 scrollSpeed, f32 gravity, f32 jumpVelocity,
+//           f32 groundY, u32 seed
+//   u64 tickCount, u32 keyframeInterval
+//   blocks, one per keyframeInterval ticks (the last may be short):
+//     keyframe: the state at the block's first tick (see writeState())
+//     varint eventCount, then per event varint(tickDelta << 1 | changed)
+//       and, if changed is set, varint input. tickDelta counts from the
+//       previous event, or the block's first tick for the first; changed
+//       is set if the input differs from the previous event's (jump for
+//       the first).
+//   hashes, if recorded: u32 hashInterval, u64 hashCount (tickCount /
+//       hashInterval), then hashCount x u32 replayStateHash()
+//   index: blockCount x u64 block offset
+//   trailer: u64 hashOffset (0 without hashes), u64 indexOffset,
+//       u32 blockCount, "BGRI" magic
+static const uint8_t replayMagic[4] = {'B', 'G', 'R', 'P'};
+static const uint8_t replayIndexMagic[4] = {'B', 'G', 'R', 'I'};
+static const size_t replayTrailerSize = 24;
+// The version also changes when the simulation rules do, since old inputs
+// would no longer reproduce the same run.
+static const uint32_t replayVersion = 2;
+
+// ------------------------------------------------------
+// Recorder
+// ------------------------------------------------------
+void ReplayRecorder::begin(const SimConfig& config, uint32_t hashInterval) {
+    current = Replay();
+    current.config = config;
+    current.hashInterval = hashInterval;
+    recording = true;
+}
+
+void ReplayRecorder::recordTick(uint64_t tick, uint32_t input) {
+    if (!recording) {
+        return;
+    }
+    if (input != 0) {
+        current.events.push_back({tick, input});
+    }
+    current.tickCount = tick + 1;
+}
+
+void ReplayRecorder::recordState(const SimState& state) {
+    uint64_t interval = current.hashInterval;
+    if (recording && interval > 0 && state.tick == (current.hashes.size() + 1) * interval) {
+        current.hashes.push_back(replayStateHash(state));
+    }
+}
+
+uint32_t replayStateHash(const SimState& state) {
+    SimStateHash hash;
+    simHashState(state, hash);
+    return uint32_t(hash.combined());
+}
+
+void ReplayRecorder::end() {
+    recording = false;
+}
+
+// ------------------------------------------------------
+// Player
+// ------------------------------------------------------
+void ReplayPlayer::start(const Replay& replayToPlay) {
+    replay = &replayToPlay;
+    nextEvent = 0;
+}
+
+bool ReplayPlayer::finished(uint64_t tick) const {
+    return !replay || tick >= replay->tickCount;
+}
+
+uint32_t ReplayPlayer::inputForTick(uint64_t tick) {
+    // Skip events for ticks that were never requested
+    while (nextEvent < replay->events.size() && replay->events[nextEvent].tick < tick) {
+        ++nextEvent;
+    }
+    if (nextEvent < replay->events.size() && replay->events[nextEvent].tick == tick) {
+        return replay->events[nextEvent++].input;
+    }
+    return 0;
+}
+
+uint64_t replayRunStepped(const Replay& replay, SimState& state,
+                          std::vector<uint64_t>* collisionTicks) {
+    simInit(state, replay.config);
+    uint64_t collisions = 0;
+    size_t nextEvent = 0;
+    for (uint64_t tick = 0; tick < replay.tickCount; ++tick) {
+        uint32_t input = 0;
+        if (nextEvent < replay.events.size() && replay.events[nextEvent].tick == tick) {
+            input = replay.events[nextEvent++].input;
+        }
+        if (simUpdate(state, replay.config, input)) {
+            ++collisions;
+            if (collisionTicks) {
+                collisionTicks->push_back(tick);
+            }
+        }
+    }
+    return collisions;
+}
+
+uint64_t replayRunFast(const Replay& replay, SimState& state,
+                       std::vector<uint64_t>* collisionTicks) {
+    simInit(state, replay.config);
+    uint64_t collisions = 0;
+    for (const auto &event : replay.events) {
+        if (event.tick >= replay.tickCount) {
+            break;
+        }
+        // Idle until the input, then apply it with a normal update
+        collisions += simFastForward(state, replay.config, event.tick - state.tick, collisionTicks);
+        if (simUpdate(state, replay.config, event.input)) {
+            ++collisions;
+            if (collisionTicks) {
+                collisionTicks->push_back(event.tick);
+            }
+        }
+    }
+    collisions += simFastForward(state, replay.config, replay.tickCount - state.tick, collisionTicks);
+    return collisions;
+}
+
+// ------------------------------------------------------
+// Seeking
+// ------------------------------------------------------
+
+// Run `state` on to the start of `tick`, applying the replay's inputs
+// from events[nextEvent] on and advancing nextEvent past the ones used.
+// Idle stretches are fast-forwarded, which gives the same states as
+// stepping.
+static void runTo(const Replay& replay, SimState& state, uint64_t tick, size_t& nextEvent) {
+    while (nextEvent < replay.events.size() && replay.events[nextEvent].tick < tick) {
+        const ReplayEvent& event = replay.events[nextEvent++];
+        if (event.tick < state.tick) {
+            continue;
+        }
+        simFastForward(state, replay.config, event.tick - state.tick);
+        simUpdate(state, replay.config, event.input);
+    }
+    simFastForward(state, replay.config, tick - state.tick);
+}
+
+// Index of the first event at or after `tick`
+static size_t firstEventFrom(const Replay& replay, uint64_t tick) {
+    size_t lo = 0;
+    size_t hi = replay.events.size();
+    while (lo < hi) {
+        size_t mid = lo + (hi - lo) / 2;
+        if (replay.events[mid].tick < tick) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+    return lo;
+}
+
+bool replaySeek(const Replay& replay, uint64_t tick, SimState& state) {
+    if (tick > replay.tickCount) {
+        return false;
+    }
+    size_t keyframe = size_t(tick / replay.keyframeInterval);
+    if (replay.keyframes.empty()) {
+        simInit(state, replay.config);
+    } else {
+        simRestore(state, replay.keyframes[keyframe < replay.keyframes.size()
+                                                ? keyframe
+                                                : replay.keyframes.size() - 1]);
+    }
+    size_t nextEvent = firstEventFrom(replay, state.tick);
+    runTo(replay, state, tick, nextEvent);
+    return true;
+}
+
+// ------------------------------------------------------
+// Serialization
+// ------------------------------------------------------
+
+// Keyframe: only the live parts of the state. Spike positions are kept
+// exactly, spawn ticks as ages, and the course as its position (its chunks
+// are regenerated from the seed).
+static void writeState(std::vector<uint8_t>& out, const SimState& state) {
+    writeVarint(out, state.tick);
+    writeF32(out, state.playerY);
+    writeF32(out, state.playerVelocity);
+    writeF32(out, state.prevPlayerY);
+    writeF32(out, state.launchY);
+    writeF32(out, state.launchVelocity);
+    out.push_back(state.isOnGround ? 1 : 0);
+    writeVarint(out, state.airTicks);
+    writeVarint(out, state.ticksSinceSpawn);
+    writeVarint(out, state.course.next);
+    writeVarint(out, state.spikes.size());
+    for (const auto &spike : state.spikes) {
+        writeF32(out, spike.x);
+        writeF32(out, spike.y);
+        writeVarint(out, state.tick - spike.spawnTick);
+    }
+}
+
+static bool readState(ByteReader& in, const SimConfig& config, SimState& state) {
+    state = SimState();
+    state.tick = in.varint();
+    state.playerY = in.f32();
+    state.playerVelocity = in.f32();
+    state.prevPlayerY = in.f32();
+    state.launchY = in.f32();
+    state.launchVelocity = in.f32();
+    state.isOnGround = in.u8() != 0;
+    uint64_t airTicks = in.varint();
+    uint64_t ticksSinceSpawn = in.varint();
+    uint64_t next = in.varint();
+    uint64_t spikes = in.varint();
+    if (!in.ok || airTicks > UINT32_MAX || ticksSinceSpawn > UINT32_MAX ||
+        spikes > SimState::maxSpikes) {
+        return false;
+    }
+    state.airTicks = uint32_t(airTicks);
+    state.ticksSinceSpawn = uint32_t(ticksSinceSpawn);
+    courseSeek(state.course, simCourseSource(config), next);
+    for (uint64_t i = 0; i < spikes; ++i) {
+        Spike spike;
+        spike.x = in.f32();
+        spike.y = in.f32();
+        uint64_t age = in.varint();
+        if (age > state.tick) {
+            return false;
+        }
+        spike.spawnTick = state.tick - age;
+        state.spikes.push_back(spike);
+    }
+    simRehashSpikes(state);
+    return in.ok;
+}
+
+// Config and length; leaves `in` at the first block
+static bool readHeader(ByteReader& in, Replay& replay) {
+    if (in.size < 8 || memcmp(in.data, replayMagic, 4) != 0) {
+        printf("Not a replay file\n");
+        return false;
+    }
+    in.pos = 4;
+    uint32_t version = in.u32();
+    if (version != replayVersion) {
+        printf("Unsupported replay version %u\n", version);
+        return false;
+    }
+    SimConfig& c = replay.config;
+    c.tickRate = in.f64();
+    c.scrollSpeed = in.f32();
+    c.gravity = in.f32();
+    c.jumpVelocity = in.f32();
+    c.groundY = in.f32();
+    c.seed = in.u32();
+    replay.tickCount = in.u64();
+    replay.keyframeInterval = in.u32();
+    if (!in.ok) {
+        printf("Truncated replay file\n");
+        return false;
+    }
+    if (!(c.tickRate > 0.0) || !(c.scrollSpeed > 0.0f) || replay.keyframeInterval == 0) {
+        printf("Invalid replay header\n");
+        return false;
+    }
+    return true;
+}
+
+struct ReplayTrailer {
+    uint64_t hashOffset;
+    uint64_t indexOffset;
+    uint32_t blockCount;
+};
+
+static bool readTrailer(const uint8_t* data, size_t size, const Replay& replay,
+                        ReplayTrailer& trailer) {
+    ByteReader in = {data, size, size >= replayTrailerSize ? size - replayTrailerSize : 0, true};
+    trailer.hashOffset = in.u64();
+    trailer.indexOffset = in.u64();
+    trailer.blockCount = in.u32();
+    uint64_t blocks = (replay.tickCount + replay.keyframeInterval - 1) / replay.keyframeInterval;
+    if (!in.ok || size < replayTrailerSize ||
+        memcmp(data + size - 4, replayIndexMagic, 4) != 0 || trailer.blockCount != blocks ||
+        trailer.indexOffset > size || size - trailer.indexOffset != blocks * 8 + replayTrailerSize) {
+        printf("Corrupt replay index\n");
+        return false;
+    }
+    return true;
+}
+
+// One block's events, appended to `events`
+static bool readEvents(ByteReader& in, uint64_t first, uint64_t last,
+                       std::vector<ReplayEvent>& events) {
+    uint64_t count = in.varint();
+    // Events are at least a byte each
+    if (!in.ok || count > last - first || !in.has(size_t(count))) {
+        return false;
+    }
+    uint64_t tick = first;
+    uint32_t input = SIM_INPUT_JUMP;
+    for (uint64_t i = 0; i < count; ++i) {
+        uint64_t v = in.varint();
+        uint64_t delta = v >> 1;
+        if ((i > 0 && delta == 0) || delta >= last - tick) {
+            return false;
+        }
+        tick += delta;
+        if (v & 1) {
+            uint64_t changed = in.varint();
+            if (changed > UINT32_MAX) {
+                return false;
+            }
+            input = uint32_t(changed);
+        }
+        events.push_back({tick, input});
+    }
+    return in.ok;
+}
+
+void replaySerialize(const Replay& replay, std::vector<uint8_t>& out) {
+    out.clear();
+    for (uint8_t byte : replayMagic) {
+        out.push_back(byte);
+    }
+    writeU32(out, replayVersion);
+
+    const SimConfig& c = replay.config;
+    writeF64(out, c.tickRate);
+    writeF32(out, c.scrollSpeed);
+    writeF32(out, c.gravity);
+    writeF32(out, c.jumpVelocity);
+    writeF32(out, c.groundY);
+    writeU32(out, c.seed);
+
+    uint32_t interval = replay.keyframeInterval > 0 ? replay.keyframeInterval : replayKeyframeInterval;
+    writeU64(out, replay.tickCount);
+    writeU32(out, interval);
+
+    // Blocks: the replay is re-run to take the keyframes
+    std::vector<uint64_t> offsets;
+    SimState state;
+    simInit(state, c);
+    size_t nextEvent = 0;
+    for (uint64_t first = 0; first < replay.tickCount; first += interval) {
+        uint64_t last = replay.tickCount - first > interval ? first + interval : replay.tickCount;
+        runTo(replay, state, first, nextEvent);
+        offsets.push_back(out.size());
+        writeState(out, state);
+
+        size_t end = nextEvent;
+        while (end < replay.events.size() && replay.events[end].tick < last) {
+            ++end;
+        }
+        writeVarint(out, end - nextEvent);
+        uint64_t tick = first;
+        uint32_t input = SIM_INPUT_JUMP;
+        for (size_t i = nextEvent; i < end; ++i) {
+            const ReplayEvent& event = replay.events[i];
+            bool changed = event.input != input;
+            writeVarint(out, (event.tick - tick) << 1 | (changed ? 1 : 0));
+            if (changed) {
+                writeVarint(out, event.input);
+            }
+            tick = event.tick;
+            input = event.input;
+        }
+    }
+
+    uint64_t hashOffset = 0;
+    if (replay.hashInterval > 0 && replay.hashes.size() == replay.tickCount / replay.hashInterval) {
+        hashOffset = out.size();
+        writeU32(out, replay.hashInterval);
+        writeU64(out, replay.hashes.size());
+        for (uint32_t hash : replay.hashes) {
+            writeU32(out, hash);
+        }
+    }
+
+    uint64_t indexOffset = out.size();
+    for (uint64_t offset : offsets) {
+        writeU64(out, offset);
+    }
+    writeU64(out, hashOffset);
+    writeU64(out, indexOffset);
+    writeU32(out, uint32_t(offsets.size()));
+    for (uint8_t byte : replayIndexMagic) {
+        out.push_back(byte);
+    }
+}
+
+bool replayDeserialize(const uint8_t* data, size_t size, Replay& out) {
+    Replay replay;
+    ByteReader in = {data, size, 0, true};
+    ReplayTrailer trailer;
+    if (!readHeader(in, replay) || !readTrailer(data, size, replay, trailer)) {
+        return false;
+    }
+    ByteReader index = {data, size, size_t(trailer.indexOffset), true};
+    SimState state;
+    for (uint32_t b = 0; b < trailer.blockCount; ++b) {
+        uint64_t first = uint64_t(b) * replay.keyframeInterval;
+        uint64_t last = replay.tickCount - first > replay.keyframeInterval
+                            ? first + replay.keyframeInterval
+                            : replay.tickCount;
+        if (index.u64() != in.pos || !readState(in, replay.config, state) || state.tick != first ||
+            !readEvents(in, first, last, replay.events)) {
+            printf("Corrupt replay block %u\n", b);
+            return false;
+        }
+        replay.keyframes.emplace_back();
+        simSave(state, replay.keyframes.back());
+    }
+
+    if (trailer.hashOffset != 0) {
+        uint32_t interval = in.u32();
+        uint64_t hashCount = in.u64();
+        if (in.pos != trailer.hashOffset + 12 || interval == 0 ||
+            hashCount != replay.tickCount / interval || hashCount > (in.size - in.pos) / 4) {
+            in.ok = false;
+        }
+        replay.hashInterval = interval;
+        for (uint64_t i = 0; in.ok && i < hashCount; ++i) {
+            replay.hashes.push_back(in.u32());
+        }
+    }
+    if (!in.ok || in.pos != trailer.indexOffset) {
+        printf("Corrupt replay file\n");
+        return false;
+    }
+
+    out = std::move(replay);
+    return true;
+}
+
+bool replaySeekSerialized(const uint8_t* data, size_t size, uint64_t tick, SimConfig& config,
+                          SimState& state) {
+    Replay replay;
+    ByteReader in = {data, size, 0, true};
+    ReplayTrailer trailer;
+    if (!readHeader(in, replay) || !readTrailer(data, size, replay, trailer) ||
+        tick > replay.tickCount) {
+        return false;
+    }
+    config = replay.config;
+    if (trailer.blockCount == 0) {
+        simInit(state, config);
+        return true;
+    }
+
+    // The block holding the tick (the end of the run is in the last one)
+    uint64_t block = tick / replay.keyframeInterval;
+    block = block < trailer.blockCount ? block : trailer.blockCount - 1;
+    ByteReader index = {data, size, size_t(trailer.indexOffset + block * 8), true};
+    uint64_t offset = index.u64();
+    if (offset >= trailer.indexOffset) {
+        return false;
+    }
+    in.pos = size_t(offset);
+    uint64_t first = block * replay.keyframeInterval;
+    uint64_t last = replay.tickCount - first > replay.keyframeInterval
+                        ? first + replay.keyframeInterval
+                        : replay.tickCount;
+    if (!readState(in, config, state) || state.tick != first ||
+        !readEvents(in, first, last, replay.events)) {
+        printf("Corrupt replay block %llu\n", (unsigned long long)block);
+        return false;
+    }
+    size_t nextEvent = 0;
+    runTo(replay, state, tick, nextEvent);
+    return true;
+}
+
+bool replayWriteFile(const Replay& replay, const char* path) {
+    std::vector<uint8_t> bytes;
+    replaySerialize(replay, bytes);
+    FILE* file = fopen(path, "wb");
+    if (!file) {
+        printf("Cannot open %s for writing\n", path);
+        return false;
+    }
+    bool ok = fwrite(bytes.data(), 1, bytes.size(), file) == bytes.size();
+    ok = (fclose(file) == 0) && ok;
+    return ok;
+}
+
+bool replayReadFile(const char* path, Replay& out) {
+    FILE* file = fopen(path, "rb");
+    if (!file) {
+        printf("Cannot open %s\n", path);
+        return false;
+    }
+    std::vector<uint8_t> bytes;
+    uint8_t buffer[4096];
+    size_t n;
+    while ((n = fread(buffer, 1, sizeof(buffer), file)) > 0) {
+        bytes.insert(bytes.end(), buffer, buffer + n);
+    }
+    fclose(file);
+    return replayDeserialize(bytes.data(), bytes.size(), out);
+}
@@ -0,0 +1,133 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "sim.h"
+#include "snapshot.h"
+#include "state_hash.h"
+
+// ------------------------------------------------------
+// Deterministic input recording and replay.
+// A replay is the starting config (including the seed) plus every
+// non-empty input stamped with the tick it was applied on. Replays always
+// start from a fresh simInit() state, so feeding the same inputs back into
+// simUpdate() reproduces the run exactly. Only seeded courses can be
+// recorded; a course file isn't part of the replay.
+// Replay files also hold a keyframe (the full state) every
+// keyframeInterval ticks and a trailing index of them, so any tick can be
+// reached by restoring one keyframe and running at most keyframeInterval
+// updates, without reading the rest of the file. Recordings can also keep
+// a 32-bit hash of the state (state_hash.h) every hashInterval ticks, so a
+// replay run on another build can be checked for the stretch of ticks it
+// diverges in; without them, compare only narrows it down to between two
+// keyframes. Hashes are kept sparse so an hour's file stays a few KB.
+// ------------------------------------------------------
+
+// Default ticks between keyframes: a minute at 60 Hz
+const uint32_t replayKeyframeInterval = 3600;
+
+// Default ticks between state hashes: five seconds at 60 Hz, 4 bytes each
+const uint32_t replayHashInterval = 300;
+
+// Input applied on the tick with index `tick` (SimState::tick before the update)
+struct ReplayEvent {
+    uint64_t tick;
+    uint32_t input;
+};
+
+struct Replay {
+    SimConfig config;
+    uint64_t tickCount = 0;          // length of the run in ticks
+    std::vector<ReplayEvent> events; // sorted by tick, at most one per tick
+
+    // State hashes (replayStateHash()): the state at the start of tick
+    // (i + 1) * hashInterval at [i]. Empty if not recorded.
+    uint32_t hashInterval = 0;
+    std::vector<uint32_t> hashes;
+
+    // Keyframes: the state at the start of tick k * keyframeInterval at
+    // [k]. Read from replay files; replaySerialize() computes its own.
+    uint32_t keyframeInterval = replayKeyframeInterval;
+    std::vector<SimSnapshot> keyframes;
+};
+
+// ------------------------------------------------------
+// Records the inputs of a live run
+// ------------------------------------------------------
+class ReplayRecorder {
+public:
+    // Start a new recording, with a state hash every hashInterval ticks
+    // (0 for none). The caller must also reset the state with simInit().
+    void begin(const SimConfig& config, uint32_t hashInterval = 0);
+
+    // Record the input used for one tick; call once per simulated tick, in order.
+    void recordTick(uint64_t tick, uint32_t input);
+
+    // Record the state the tick left behind; call after its simUpdate().
+    void recordState(const SimState& state);
+
+    // Stop recording; the replay stays available until the next begin().
+    void end();
+
+    bool isRecording() const { return recording; }
+    const Replay& replay() const { return current; }
+
+private:
+    Replay current;
+    bool recording = false;
+};
+
+// ------------------------------------------------------
+// Feeds a recorded run's inputs back tick by tick
+// ------------------------------------------------------
+class ReplayPlayer {
+public:
+    // The replay must outlive the player.
+    void start(const Replay& replay);
+
+    // True once every recorded tick has been played.
+    bool finished(uint64_t tick) const;
+
+    // Input for the given tick. Ticks must be requested in increasing order.
+    uint32_t inputForTick(uint64_t tick);
+
+private:
+    const Replay* replay = nullptr;
+    size_t nextEvent = 0;
+};
+
+// Replay a whole run as fast as possible, with no rendering. The state is
+// reset first. If collisionTicks is given, the index of every tick that
+// ended in a collision is appended to it. Returns the number of collisions.
+// Stretches without input are fast-forwarded from event to event
+// (fast_forward.h), with results identical to replayRunStepped().
+uint64_t replayRunFast(const Replay& replay, SimState& state,
+                       std::vector<uint64_t>* collisionTicks = nullptr);
+
+// The same, calling simUpdate() for every tick.
+uint64_t replayRunStepped(const Replay& replay, SimState& state,
+                          std::vector<uint64_t>* collisionTicks = nullptr);
+
+// The state at the start of `tick` (at most tickCount), from the nearest
+// keyframe before it, or from the start if the replay has none. Returns
+// false if the tick is past the end.
+bool replaySeek(const Replay& replay, uint64_t tick, SimState& state);
+
+// The hash of a state recorded in replays: SimStateHash::combined(),
+// truncated to 32 bits
+uint32_t replayStateHash(const SimState& state);
+
+// Binary serialization (little-endian, versioned)
+void replaySerialize(const Replay& replay, std::vector<uint8_t>& out);
+bool replayDeserialize(const uint8_t* data, size_t size, Replay& out);
+
+// replaySeek() straight from serialized bytes: reads only the header,
+// the index and the one block of keyframe and inputs the tick is in.
+// `config` is set to the replay's config.
+bool replaySeekSerialized(const uint8_t* data, size_t size, uint64_t tick, SimConfig& config,
+                          SimState& state);
+
+bool replayWriteFile(const Replay& replay, const char* path);
+bool replayReadFile(const char* path, Replay& out);
@@ -0,0 +1,65 @@
+#include "rewind.h"
+
+void RewindHistory::reset(uint64_t ticks, uint32_t keyframeInterval) {
+    interval = keyframeInterval > 0 ? keyframeInterval : 1;
+    // One keyframe more than the span needs: the newest only covers the
+    // ticks since it was taken
+    size_t keyframeCount = ticks > 0 ? size_t((ticks + interval - 1) / interval) + 1 : 0;
+    keyframes.reset(keyframeCount);
+    inputs.assign(keyframeCount * interval, 0);
+    end = 0;
+}
+
+void RewindHistory::clear() {
+    keyframes.clear();
+    end = 0;
+}
+
+void RewindHistory::record(const SimState& state, uint32_t input) {
+    if (!isEnabled()) {
+        return;
+    }
+    if (keyframes.empty() || state.tick != end) {
+        clear();
+    }
+    if (keyframes.empty() || state.tick - keyframes.fromNewest(0).state.tick >= interval) {
+        keyframes.push(state);
+    }
+    inputs[state.tick % inputs.size()] = uint8_t(input);
+    end = state.tick + 1;
+}
+
+uint64_t RewindHistory::firstTick() const {
+    return keyframes.empty() ? end : keyframes.fromNewest(keyframes.size() - 1).state.tick;
+}
+
+// ------------------------------------------------------
+// Restore the keyframe at or before the tick and re-simulate up to it
+// ------------------------------------------------------
+bool RewindHistory::seek(uint64_t tick, const SimConfig& config, SimState& out) const {
+    const SimSnapshot* keyframe = keyframes.atOrBefore(tick);
+    if (!keyframe || tick > end) {
+        return false;
+    }
+    simRestore(out, *keyframe);
+    while (out.tick < tick) {
+        simUpdate(out, config, inputAt(out.tick));
+    }
+    return true;
+}
+
+void RewindHistory::truncate(uint64_t tick) {
+    if (tick < end) {
+        keyframes.discardAfter(tick);
+        end = keyframes.empty() ? 0 : tick;
+    }
+}
+
+size_t RewindHistory::memoryBytes() const {
+    return keyframes.capacity() * sizeof(SimSnapshot) + inputs.size();
+}
+
+double RewindHistory::bytesPerMinute(double tickRate) const {
+    double ticks = 60.0 * tickRate;
+    return ticks / interval * double(sizeof(SimSnapshot)) + ticks;
+}
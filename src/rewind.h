@@ -0,0 +1,68 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "sim.h"
+#include "snapshot.h"
+
+// ------------------------------------------------------
+// Rewind history for time-travel debugging.
+// Keeps the last stretch of a run as keyframes (a snapshot every
+// keyframeInterval ticks, snapshot.h) plus every tick's input. The state
+// at the start of any tick in the history is rebuilt by restoring the
+// nearest keyframe before it and re-simulating the recorded inputs, so it
+// costs at most keyframeInterval - 1 updates, and memory is a fraction of
+// a snapshot per tick. All storage is allocated by reset(). The history
+// must be replayed with the config it was recorded with.
+//
+// Inputs are kept as one byte per tick rather than delta-coded between
+// keyframes like replay files' events. The keyframes are nearly all of
+// the memory (a minute at 60 Hz with a keyframe every 30 ticks is about
+// 190 KB of keyframes against 3.5 KB of inputs). A delta-coded stream
+// would still have to preallocate a byte per tick for worst-case input,
+// and it would give up inputAt()'s constant-time lookup.
+// ------------------------------------------------------
+class RewindHistory {
+public:
+    // Allocate room for at least `ticks` ticks of history, with a keyframe
+    // every `keyframeInterval` ticks. Drops any history held.
+    void reset(uint64_t ticks, uint32_t keyframeInterval);
+
+    // Forget the history, keeping the storage
+    void clear();
+
+    bool isEnabled() const { return keyframes.capacity() > 0; }
+
+    // Record a tick: call before its simUpdate() with the state it starts
+    // from and its input. A state that doesn't continue the history (a new
+    // game, say) starts a new one.
+    void record(const SimState& state, uint32_t input);
+
+    // States that can be rebuilt: the start of ticks firstTick() to
+    // endTick(), where endTick() is the tick after the last one recorded
+    // (so the current state of the run being recorded)
+    uint64_t firstTick() const;
+    uint64_t endTick() const { return end; }
+
+    // Rebuild the state at the start of `tick`. Returns false if it is
+    // outside the history.
+    bool seek(uint64_t tick, const SimConfig& config, SimState& out) const;
+
+    // Input recorded for `tick`, which must be in [firstTick(), endTick())
+    uint32_t inputAt(uint64_t tick) const { return inputs[tick % inputs.size()]; }
+
+    // Drop the history from the start of `tick` on, to branch off from it
+    void truncate(uint64_t tick);
+
+    // Preallocated storage, and what a minute of history costs at a tick rate
+    size_t memoryBytes() const;
+    double bytesPerMinute(double tickRate) const;
+
+private:
+    SnapshotRing keyframes;
+    std::vector<uint8_t> inputs; // by tick, modulo size; SimInputBits fit in a byte
+    uint32_t interval = 1;
+    uint64_t end = 0;
+};
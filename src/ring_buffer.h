@@ -0,0 +1,82 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+// ------------------------------------------------------
+// Fixed-capacity FIFO ring buffer with inline storage.
+// Never allocates: push_back() fails when the buffer is full. Meant for
+// scrolling obstacles, which are spawned at the back in x order and leave
+// from the front, so despawning is pop_front() instead of an erase.
+// Trivially copyable whenever T is, so states holding one can be memcpy'd.
+// ------------------------------------------------------
+template <typename T, size_t Capacity>
+class RingBuffer {
+    static_assert(Capacity > 0 && (Capacity & (Capacity - 1)) == 0,
+                  "RingBuffer capacity must be a power of two");
+
+public:
+    template <typename Buffer, typename Value>
+    class Iterator {
+    public:
+        Iterator(Buffer* buffer, size_t index) : buffer(buffer), index(index) {}
+        Value& operator*() const { return (*buffer)[index]; }
+        Value* operator->() const { return &(*buffer)[index]; }
+        Iterator& operator++() { ++index; return *this; }
+        bool operator==(const Iterator& other) const { return index == other.index; }
+        bool operator!=(const Iterator& other) const { return index != other.index; }
+
+    private:
+        Buffer* buffer;
+        size_t index;
+    };
+    typedef Iterator<RingBuffer, T> iterator;
+    typedef Iterator<const RingBuffer, const T> const_iterator;
+
+    static constexpr size_t capacity() { return Capacity; }
+    size_t size() const { return count; }
+    bool empty() const { return count == 0; }
+    bool full() const { return count == Capacity; }
+
+    // Append at the back; returns false (and drops the item) when full.
+    bool push_back(const T& item) {
+        if (count == Capacity) {
+            return false;
+        }
+        items[(head + count) & mask] = item;
+        ++count;
+        return true;
+    }
+
+    // Remove the oldest item. The buffer must not be empty.
+    void pop_front() {
+        head = (head + 1) & mask;
+        --count;
+    }
+
+    void clear() {
+        head = 0;
+        count = 0;
+    }
+
+    // Index 0 is the oldest item (the front).
+    T& operator[](size_t i) { return items[(head + i) & mask]; }
+    const T& operator[](size_t i) const { return items[(head + i) & mask]; }
+
+    T& front() { return items[head]; }
+    const T& front() const { return items[head]; }
+    T& back() { return items[(head + count - 1) & mask]; }
+    const T& back() const { return items[(head + count - 1) & mask]; }
+
+    iterator begin() { return iterator(this, 0); }
+    iterator end() { return iterator(this, count); }
+    const_iterator begin() const { return const_iterator(this, 0); }
+    const_iterator end() const { return const_iterator(this, count); }
+
+private:
+    static constexpr size_t mask = Capacity - 1;
+
+    T items[Capacity];
+    uint32_t head = 0;
+    uint32_t count = 0;
+};
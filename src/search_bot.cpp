@@ -0,0 +1,272 @@
+#include "search_bot.h"
+
+#include <cmath>
+
+#include "hash.h"
+
+// Memo entries pack the node's fingerprint with its result:
+//   bits 63-33  key fingerprint (top 31 bits of the key)
+//   bit  32     best first input is a jump
+//   bits 31-16  furthest tick reached, relative to the node's tick
+//   bits 15-0   horizon it was searched to, relative to the node's tick
+// A zero entry never settles a lookup.
+static const uint64_t memoRelativeMax = 0xFFFF;
+
+// Quantization of the player's state in node keys
+static const float keyPositionScale = 4096.0f;
+static const float keyVelocityScale = 65536.0f;
+
+// One decision point on the search path
+struct SearchBot::Frame {
+    uint64_t key;
+    uint64_t best;      // furthest tick reached by the inputs tried so far
+    uint32_t first;     // input tried first
+    uint32_t current;   // input being searched
+    uint32_t bestInput;
+    uint32_t tried;     // inputs tried, 0 to 2
+};
+
+// Per-task search stacks: states[d] is the node at depth d
+struct SearchBot::Workspace {
+    std::vector<SimState> states;
+    std::vector<Frame> frames;
+    SearchStats stats;
+};
+
+static uint64_t quantize(float v, float scale) {
+    return uint32_t(int32_t(lrintf(v * scale)));
+}
+
+// ------------------------------------------------------
+// Memo key of a node: its tick, what tells the world at that tick apart
+// from a world a collision has cleared, and the player, quantized.
+// prevPlayerY is left out: simUpdate() overwrites it before reading it.
+// ------------------------------------------------------
+static uint64_t nodeKey(const SimState& state) {
+    uint64_t h = hashMix(state.tick);
+    h = hashMix(h ^ state.course.next ^ (uint64_t(state.spikes.size()) << 56));
+    h = hashMix(h ^ quantize(state.playerY, keyPositionScale) ^
+                (quantize(state.playerVelocity, keyVelocityScale) << 32));
+    h = hashMix(h ^ state.isOnGround);
+    return h;
+}
+
+// ------------------------------------------------------
+// Apply a node's input and run on until the player stands on the ground
+// again or the horizon is reached. Returns false on a collision, with the
+// tick it happened on in `reach`.
+// ------------------------------------------------------
+static bool advance(SimState& state, const SimConfig& config, uint32_t input, uint64_t horizonEnd,
+                    uint64_t& reach, SearchStats& stats) {
+    do {
+        uint64_t tick = state.tick;
+        ++stats.updates;
+        if (simUpdate(state, config, input)) {
+            reach = tick;
+            return false;
+        }
+        input = 0;
+    } while (!state.isOnGround && state.tick < horizonEnd);
+    return true;
+}
+
+SearchBot::SearchBot(double horizonSeconds, unsigned memoBits)
+    : horizon(horizonSeconds), memo(new std::atomic<uint64_t>[size_t(1) << memoBits]),
+      memoMask((uint64_t(1) << memoBits) - 1) {
+    clear();
+    setParallel(nullptr, 1);
+}
+
+SearchBot::~SearchBot() {
+}
+
+void SearchBot::setParallel(SearchParallelFor newParallelFor, size_t tasks) {
+    parallelFor = std::move(newParallelFor);
+    // The split needs a "jump now" and a "wait" subtree
+    tasks = parallelFor ? (tasks > 2 ? tasks : 2) : 1;
+    workspaces.clear();
+    for (size_t i = 0; i < tasks; ++i) {
+        workspaces.emplace_back(new Workspace());
+    }
+}
+
+void SearchBot::clear() {
+    for (uint64_t i = 0; i <= memoMask; ++i) {
+        memo[i].store(0, std::memory_order_relaxed);
+    }
+}
+
+uint64_t SearchBot::horizonTicks(const SimConfig& simConfig) const {
+    double ticks = horizon * simConfig.tickRate;
+    ticks = ticks < 1.0 ? 1.0 : ticks;
+    return ticks < double(memoRelativeMax) ? uint64_t(ticks) : memoRelativeMax;
+}
+
+bool SearchBot::lookup(uint64_t key, uint64_t tick, uint64_t horizonEnd, uint64_t& reach,
+                       uint32_t& hint) {
+    uint64_t entry = memo[key & memoMask].load(std::memory_order_relaxed);
+    if ((entry >> 33) != (key >> 33)) {
+        return false;
+    }
+    hint = (entry >> 32) & 1 ? SIM_INPUT_JUMP : 0;
+    uint64_t reached = tick + ((entry >> 16) & 0xFFFF);
+    uint64_t searched = tick + (entry & 0xFFFF);
+    if (reached < searched) {
+        // Every input collides by then: that holds for any horizon
+        reach = reached < horizonEnd ? reached : horizonEnd;
+        return true;
+    }
+    if (reached >= horizonEnd) {
+        reach = horizonEnd;
+        return true;
+    }
+    // It survived a shorter horizon: search again, its best input first
+    return false;
+}
+
+void SearchBot::store(uint64_t key, uint64_t tick, uint64_t horizonEnd, uint64_t reach,
+                      uint32_t input) {
+    uint64_t entry = (key >> 33) << 33 | uint64_t((input & SIM_INPUT_JUMP) != 0) << 32 |
+                     (reach - tick) << 16 | (horizonEnd - tick);
+    memo[key & memoMask].store(entry, std::memory_order_relaxed);
+}
+
+// ------------------------------------------------------
+// Furthest tick reachable from the node in work.states[0] (on the
+// ground, before horizonEnd): a depth-first search with an explicit
+// stack, stopping at the first input that survives to the horizon
+// ------------------------------------------------------
+uint64_t SearchBot::explore(Workspace& work, uint64_t horizonEnd) {
+    std::vector<SimState>& states = work.states;
+    std::vector<Frame>& frames = work.frames;
+    size_t depth = 0;
+
+    // Set up the frame of the node at `depth`; false (with its reach) if
+    // the memo settles it
+    auto enter = [&](size_t d, uint64_t& reach) {
+        uint64_t key = nodeKey(states[d]);
+        uint32_t hint = 0;
+        if (lookup(key, states[d].tick, horizonEnd, reach, hint)) {
+            ++work.stats.memoHits;
+            return false;
+        }
+        ++work.stats.nodes;
+        frames[d] = {key, 0, hint, hint, hint, 0};
+        return true;
+    };
+
+    uint64_t reach;
+    if (!enter(0, reach)) {
+        return reach;
+    }
+    for (;;) {
+        Frame& frame = frames[depth];
+        if (frame.tried == 2 || frame.best >= horizonEnd) {
+            store(frame.key, states[depth].tick, horizonEnd, frame.best, frame.bestInput);
+            reach = frame.best;
+            if (depth == 0) {
+                return reach;
+            }
+            --depth;
+        } else {
+            frame.current = frame.tried == 0 ? frame.first : frame.first ^ SIM_INPUT_JUMP;
+            ++frame.tried;
+            SimState& child = states[depth + 1];
+            child = states[depth];
+            if (advance(child, config, frame.current, horizonEnd, reach, work.stats)) {
+                if (child.tick >= horizonEnd) {
+                    reach = horizonEnd;
+                } else if (enter(depth + 1, reach)) {
+                    ++depth;
+                    continue;
+                }
+            }
+        }
+        // A child's result: keep the best input
+        Frame& parent = frames[depth];
+        if (reach > parent.best) {
+            parent.best = reach;
+            parent.bestInput = parent.current;
+        }
+    }
+}
+
+// ------------------------------------------------------
+// Furthest tick reachable by waiting `waitTicks` ticks on the ground from
+// the root (in work.states[0]), then applying `input`, then playing on
+// as well as possible
+// ------------------------------------------------------
+uint64_t SearchBot::searchFrom(Workspace& work, uint32_t input, uint64_t waitTicks,
+                               uint64_t horizonEnd) {
+    SimState& state = work.states[0];
+    uint64_t reach;
+    for (uint64_t i = 0; i <= waitTicks; ++i) {
+        if (!advance(state, config, i == waitTicks ? input : 0, horizonEnd, reach, work.stats)) {
+            return reach;
+        }
+        if (state.tick >= horizonEnd) {
+            return horizonEnd;
+        }
+    }
+    return explore(work, horizonEnd);
+}
+
+uint32_t SearchBot::decide(const SimState& state, const SimConfig& simConfig) {
+    // Input only matters on the ground
+    if (!state.isOnGround) {
+        return 0;
+    }
+    if (!haveConfig || simConfig.tickRate != config.tickRate ||
+        simConfig.scrollSpeed != config.scrollSpeed || simConfig.gravity != config.gravity ||
+        simConfig.jumpVelocity != config.jumpVelocity || simConfig.groundY != config.groundY ||
+        simConfig.seed != config.seed || simConfig.courseFile != config.courseFile) {
+        config = simConfig;
+        haveConfig = true;
+        clear();
+    }
+
+    // Every depth advances at least a tick
+    uint64_t ticks = horizonTicks(config);
+    uint64_t horizonEnd = state.tick + ticks;
+    for (auto &work : workspaces) {
+        work->states.resize(size_t(ticks) + 2);
+        work->frames.resize(size_t(ticks) + 2);
+        work->stats = SearchStats();
+    }
+
+    // Jump now, against the best of waiting: serially, both root inputs
+    // in full; split, "wait k ticks then jump" for each k < tasks - 1,
+    // and "wait tasks - 1 ticks" then anything
+    size_t tasks = workspaces.size();
+    std::vector<uint64_t> reaches(tasks);
+    auto search = [&](size_t k) {
+        Workspace& work = *workspaces[k];
+        work.states[0] = state;
+        size_t last = tasks - 1;
+        reaches[k] = k < last ? searchFrom(work, SIM_INPUT_JUMP, k, horizonEnd)
+                              : searchFrom(work, 0, last - 1, horizonEnd);
+    };
+    uint64_t jumpReach;
+    uint64_t waitReach = 0;
+    if (tasks == 1) {
+        Workspace& work = *workspaces[0];
+        work.states[0] = state;
+        jumpReach = searchFrom(work, SIM_INPUT_JUMP, 0, horizonEnd);
+        work.states[0] = state;
+        waitReach = searchFrom(work, 0, 0, horizonEnd);
+    } else {
+        parallelFor(tasks, search);
+        jumpReach = reaches[0];
+        for (size_t k = 1; k < tasks; ++k) {
+            waitReach = reaches[k] > waitReach ? reaches[k] : waitReach;
+        }
+    }
+
+    ++totals.decisions;
+    for (const auto &work : workspaces) {
+        totals.nodes += work->stats.nodes;
+        totals.updates += work->stats.updates;
+        totals.memoHits += work->stats.memoHits;
+    }
+    return jumpReach > waitReach ? SIM_INPUT_JUMP : 0;
+}
@@ -0,0 +1,93 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <vector>
+
+#include "sim.h"
+
+// ------------------------------------------------------
+// Lookahead search bot: a reference opponent and difficulty calibrator.
+// Every tick the player stands on the ground, decide() searches the tree
+// of jump / don't-jump decisions up to a horizon a few seconds ahead, by
+// copying the state and stepping simUpdate(), and jumps only if jumping
+// now survives longer than waiting. In the air input does nothing, so a
+// jump is followed straight to its landing and the tree only branches on
+// the ground.
+//
+// The spikes don't depend on the player, so (until a collision) the
+// world at a tick is the same down every branch and a node is identified
+// by its tick and the player's state, quantized. Results are memoized
+// under that key in a fixed-size lock-free table that persists across
+// decisions. Few lookups settle a node outright (well under 1% with the
+// default horizon): the horizon moves on a tick every decision, so a node
+// that survived the last one must be searched again to the new end. What
+// the memo buys is the order of the search: a node proven to collide
+// stays proven, and one that survived is searched again best input first,
+// which usually runs straight down the line found last time. A decision
+// costs about 1.2 times the horizon's length in updates that way, against
+// about 2.3 times without the memo; either way, not exponential in it.
+//
+// Natively the search can be split across threads (setParallel()): the
+// root is divided into "wait k ticks, then jump" subtrees that share the
+// memo table. Decisions are the same with or without splitting.
+// Seeded courses only: a streamed course file may not have the chunks the
+// search looks ahead into.
+// ------------------------------------------------------
+
+// Run body(i) for every i in [0, count), possibly on several threads,
+// returning once all have finished
+using SearchParallelFor = std::function<void(size_t count, const std::function<void(size_t)>& body)>;
+
+struct SearchStats {
+    uint64_t decisions = 0; // decide() calls that searched
+    uint64_t nodes = 0;     // decision points expanded
+    uint64_t updates = 0;   // simUpdate() calls
+    uint64_t memoHits = 0;  // nodes settled by the memo table without a search
+};
+
+class SearchBot {
+public:
+    // Search horizonSeconds ahead, memoizing in 2^memoBits entries (8 bytes each)
+    explicit SearchBot(double horizonSeconds = 3.0, unsigned memoBits = 18);
+    ~SearchBot();
+    SearchBot(const SearchBot&) = delete;
+    SearchBot& operator=(const SearchBot&) = delete;
+
+    // Split each search into `tasks` subtrees run through parallelFor
+    // (nullptr: search on the calling thread)
+    void setParallel(SearchParallelFor parallelFor, size_t tasks);
+
+    // Input for the next tick of the game in `state`
+    uint32_t decide(const SimState& state, const SimConfig& config);
+
+    // Forget the memo table; done automatically when the config changes
+    void clear();
+
+    const SearchStats& stats() const { return totals; }
+    double horizonSeconds() const { return horizon; }
+
+private:
+    struct Frame;
+    struct Workspace;
+
+    uint64_t horizonTicks(const SimConfig& config) const;
+    uint64_t searchFrom(Workspace& work, uint32_t input, uint64_t waitTicks, uint64_t horizonEnd);
+    uint64_t explore(Workspace& work, uint64_t horizonEnd);
+    bool lookup(uint64_t key, uint64_t tick, uint64_t horizonEnd, uint64_t& reach, uint32_t& hint);
+    void store(uint64_t key, uint64_t tick, uint64_t horizonEnd, uint64_t reach, uint32_t input);
+
+    double horizon;
+    SimConfig config;
+    bool haveConfig = false;
+
+    std::unique_ptr<std::atomic<uint64_t>[]> memo;
+    uint64_t memoMask;
+
+    SearchParallelFor parallelFor;
+    std::vector<std::unique_ptr<Workspace>> workspaces; // one per task
+    SearchStats totals;
+};
@@ -0,0 +1,201 @@
+#include "sim.h"
+
+#include <cmath>
+
+#include "ballistics.h"
+#include "collision.h"
+#include "hash.h"
+#include "trace.h"
+
+// ------------------------------------------------------
+// Reset the state to the start of a new game
+// ------------------------------------------------------
+void simInit(SimState& state, const SimConfig& config) {
+    state = SimState();
+    courseStart(state.course, simCourseSource(config));
+}
+
+uint64_t simSpikeHash(const Spike& spike) {
+    return hashMix(hashMix(spike.spawnTick) ^ hashFloatBits(spike.y));
+}
+
+void simRehashSpikes(SimState& state) {
+    state.spikesHash = 0;
+    for (const auto &spike : state.spikes) {
+        state.spikesHash += simSpikeHash(spike);
+    }
+}
+
+float simSpikeStep(const SimConfig& config) {
+    return config.scrollSpeed * float(1.0 / config.tickRate) * 60.0f;
+}
+
+float simSpikeX(const SimConfig& config, const Spike& spike, uint64_t tick) {
+    return simSpikeSpawnX - simSpikeStep(config) * float(tick - spike.spawnTick);
+}
+
+uint32_t simGapTicks(const SimConfig& config, uint32_t gap) {
+    // Past the end of the course, or not scrolling: never spawns
+    const uint32_t never = 1000000000;
+    if (gap == courseEndGap) {
+        return never;
+    }
+    // The small bias keeps gaps that are whole ticks up to float rounding
+    // (2.4 units at 0.02 per tick) from rounding up to the next tick.
+    double perTick = double(config.scrollSpeed) * 60.0 / config.tickRate;
+    double ticks = std::ceil(double(gap) * double(courseUnit) / perTick - 1e-4);
+    if (!(ticks < double(never))) {
+        return never;
+    }
+    return ticks < 1.0 ? 1 : uint32_t(ticks);
+}
+
+uint32_t simSpawnGapTicks(const SimState& state, const SimConfig& config) {
+    return simGapTicks(config, courseNext(state.course).gap);
+}
+
+float simObstacleY(const SimConfig& config, uint8_t kind) {
+    return kind == COURSE_FLOATING_SPIKE ? config.groundY + simFloatingSpikeLift : config.groundY;
+}
+
+CourseSource simCourseSource(const SimConfig& config) {
+    CourseSource source;
+    source.seed = config.seed;
+    source.file = config.courseFile;
+    return source;
+}
+
+bool simPrefetchCourse(SimState& state, const SimConfig& config) {
+    return coursePrefetch(state.course, simCourseSource(config));
+}
+
+// ------------------------------------------------------
+// Rescale the state's tick counts to a new tick rate
+// ------------------------------------------------------
+void simSetTickRate(SimState& state, SimConfig& config, double tickRate) {
+    double scale = tickRate / config.tickRate;
+    auto rescale = [scale](uint64_t ticks) { return uint64_t(std::llround(double(ticks) * scale)); };
+    for (auto &spike : state.spikes) {
+        uint64_t age = rescale(state.tick - spike.spawnTick);
+        spike.spawnTick = state.tick - (age < state.tick ? age : state.tick);
+    }
+    simRehashSpikes(state);
+    state.airTicks = uint32_t(rescale(state.airTicks));
+    config.tickRate = tickRate;
+    uint32_t sinceSpawn = uint32_t(rescale(state.ticksSinceSpawn));
+    uint32_t interval = simSpawnGapTicks(state, config);
+    state.ticksSinceSpawn = sinceSpawn < interval ? sinceSpawn : interval - 1;
+}
+
+// Stand the player on the ground, starting a new (resting) arc
+static void landPlayer(SimState& state, const SimConfig& config) {
+    state.playerY = config.groundY;
+    state.playerVelocity = 0.0f;
+    state.isOnGround = true;
+    state.launchY = config.groundY;
+    state.launchVelocity = 0.0f;
+    state.airTicks = 0;
+}
+
+// Index of the first spike that was still right of the player's column at
+// the start of this tick. Spikes are spawned in x order and all move at the
+// same speed, so the ring stays sorted by x and a binary search finds it;
+// every spike before it has already passed the player.
+static size_t firstNearSpike(const SimState& state, const SimConfig& config) {
+    size_t lo = 0;
+    size_t hi = state.spikes.size();
+    while (lo < hi) {
+        size_t mid = lo + (hi - lo) / 2;
+        if (simSpikeX(config, state.spikes[mid], state.tick - 1) > -simHitHalfWidth) {
+            hi = mid;
+        } else {
+            lo = mid + 1;
+        }
+    }
+    return lo;
+}
+
+// ------------------------------------------------------
+// Update game logic: player physics, spike spawning/movement, collision.
+// Advances the simulation by exactly one fixed tick.
+// ------------------------------------------------------
+bool simUpdate(SimState& state, const SimConfig& config, uint32_t input) {
+    TRACE_SCOPE("update");
+    state.prevPlayerY = state.playerY;
+    ++state.tick;
+
+    // Handle a jump request: start a new arc from the current height
+    if ((input & SIM_INPUT_JUMP) && state.isOnGround) {
+        state.launchY = state.playerY;
+        state.launchVelocity = config.jumpVelocity;
+        state.airTicks = 0;
+        state.isOnGround = false;
+    }
+
+    // Update player physics: sample the closed-form arc (gravity and jump)
+    // at this tick rather than integrating, so the trajectory is the same
+    // at every tick rate. Velocities are per 60 Hz frame, like scrollSpeed.
+    ++state.airTicks;
+    state.playerY = state.launchY + arcOffset(config, state.launchVelocity, state.airTicks);
+    state.playerVelocity = arcVelocity(config, state.launchVelocity, state.airTicks);
+    if (state.playerY < config.groundY) {
+        // Simulate ground collision
+        landPlayer(state, config);
+    }
+
+    // Spawn the next obstacle of the course once the world has scrolled
+    // its gap
+    {
+        TRACE_SCOPE("spawn");
+        if (++state.ticksSinceSpawn >= simSpawnGapTicks(state, config)) {
+            state.ticksSinceSpawn = 0;
+            // Spawn spike off-screen to the right; it moves on this tick too
+            float y = simObstacleY(config, courseNext(state.course).kind);
+            Spike spike = {simSpikeSpawnX, y, state.tick - 1};
+            if (state.spikes.push_back(spike)) {
+                state.spikesHash += simSpikeHash(spike);
+            }
+            courseAdvance(state.course, simCourseSource(config));
+        }
+    }
+
+    // Move spikes to the left
+    {
+        TRACE_SCOPE("move");
+        for (auto &spike : state.spikes) {
+            spike.x = simSpikeX(config, spike, state.tick);
+        }
+    }
+
+    // Remove spikes that have gone off-screen to the left. Spikes are
+    // spawned in x order, so they always leave from the front.
+    {
+        TRACE_SCOPE("cull");
+        while (!state.spikes.empty() && state.spikes.front().x < simSpikeDespawnX) {
+            state.spikesHash -= simSpikeHash(state.spikes.front());
+            state.spikes.pop_front();
+        }
+    }
+
+    // Check collisions. Broadphase: only the spikes whose sweep over this
+    // tick crosses the player's column can touch it. Narrowphase: sweep
+    // the exact shapes over the tick, so spikes can't tunnel through the
+    // player however far they move per tick.
+    TRACE_SCOPE("collision");
+    for (size_t i = firstNearSpike(state, config); i < state.spikes.size(); ++i) {
+        const Spike& spike = state.spikes[i];
+        if (spike.x >= simHitHalfWidth) {
+            break; // this and every later spike is still to the right
+        }
+        float prevX = simSpikeX(config, spike, state.tick - 1);
+        if (collideSwept(prevX, spike.x, spike.y, state.prevPlayerY, state.playerY)) {
+            // Collision: reset player state and clear spikes
+            landPlayer(state, config);
+            state.spikes.clear();
+            state.spikesHash = 0;
+            state.prevPlayerY = state.playerY;
+            return true;
+        }
+    }
+    return false;
+}
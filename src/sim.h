@@ -0,0 +1,133 @@
+#pragma once
+
+#include <cstdint>
+
+#include "course.h"
+#include "ring_buffer.h"
+
+// ------------------------------------------------------
+// Platform-free game simulation.
+// No Emscripten or GL dependencies: this is shared by the web build
+// (main.cpp) and the native headless runner (headless.cpp).
+// ------------------------------------------------------
+
+// Structure for spikes
+struct Spike {
+    float x;
+    float y;
+    uint64_t spawnTick; // tick at which x was simSpikeSpawnX (see simSpikeX())
+};
+
+// Tunable simulation parameters
+struct SimConfig {
+    double tickRate = 60.0;          // simulation ticks per second
+    float scrollSpeed = 0.02f;       // speed at which spikes move left (per 60 Hz frame)
+    float gravity = -0.06f;
+    float jumpVelocity = 0.02f;      // per 60 Hz frame
+    float groundY = -0.4f;
+    uint32_t seed = 0;               // course seed (see course.h), recorded with replays
+    const CourseFile* courseFile = nullptr; // designer course to play instead (course_file.h)
+};
+
+// Spikes appear at the right edge and are removed past the left one
+const float simSpikeSpawnX = 1.2f;
+const float simSpikeDespawnX = -1.2f;
+
+// Height of a COURSE_FLOATING_SPIKE's base above the ground: clear of a
+// standing player, in the way of a jumping one
+const float simFloatingSpikeLift = 0.12f;
+
+// Shapes, matching the meshes drawn by main.cpp: the player is a square
+// centred on (0, playerY); a spike is a triangle with its base centred on
+// (x, y) and its apex simSpikeHeight above that.
+const float simPlayerHalfSize = 0.05f;
+const float simSpikeHalfWidth = 0.05f;
+const float simSpikeHeight = 0.1f;
+
+// Broad bounds: a spike can only touch the player while |x| is below
+// simHitHalfWidth, and not while the player's centre is simHitClearance
+// or more above the spike's base.
+const float simHitHalfWidth = simSpikeHalfWidth + simPlayerHalfSize;
+const float simHitClearance = simSpikeHeight + simPlayerHalfSize;
+
+// Player input for one tick, as a bitmask
+enum SimInputBits : uint32_t {
+    SIM_INPUT_JUMP = 1u << 0  // jump if standing on the ground
+};
+
+// Complete mutable game state
+struct SimState {
+    // Upper bound on live spikes; spawns beyond this are dropped.
+    static const size_t maxSpikes = 64;
+
+    // Player state
+    float playerY = 0.0f;        // Player vertical position
+    float playerVelocity = 0.0f; // Player vertical velocity
+    bool  isOnGround = true;
+    float prevPlayerY = 0.0f;    // position at the previous tick, for interpolation
+
+    // Current flight (see ballistics.h): playerY is launchY plus the arc
+    // offset after airTicks ticks, and playerVelocity its derivative.
+    float launchY = 0.0f;
+    float launchVelocity = 0.0f;
+    uint32_t airTicks = 0;
+
+    // World scrolling state
+    CourseCursor course;          // obstacles still to come
+    uint32_t ticksSinceSpawn = 0; // the next obstacle spawns when it reaches simSpawnGapTicks()
+    RingBuffer<Spike, maxSpikes> spikes; // ordered by x, oldest (leftmost) first
+    // Sum of simSpikeHash() over the live spikes, kept up to date as they
+    // spawn and leave so per-tick state hashes needn't walk them
+    uint64_t spikesHash = 0;
+
+    uint64_t tick = 0;           // number of ticks simulated so far (index of the next tick)
+};
+
+// Reset the state to the start of a new game on the course for config.seed.
+void simInit(SimState& state, const SimConfig& config);
+
+// Advance the simulation by one fixed tick of 1 / config.tickRate seconds,
+// applying the input (SimInputBits) first. The outcome depends only on the
+// state, config and input, so runs can be recorded and replayed exactly.
+// Returns true if the player hit a spike (the state has then been reset).
+bool simUpdate(SimState& state, const SimConfig& config, uint32_t input);
+
+// A spike's term in SimState::spikesHash: its y and spawn tick.
+uint64_t simSpikeHash(const Spike& spike);
+
+// Recompute state.spikesHash; call after editing state.spikes other than
+// through simUpdate().
+void simRehashSpikes(SimState& state);
+
+// Horizontal distance a spike travels in one tick.
+float simSpikeStep(const SimConfig& config);
+
+// Spike position at `tick`. Positions are a closed-form function of the
+// spike's age rather than accumulated, so any tick can be computed directly.
+float simSpikeX(const SimConfig& config, const Spike& spike, uint64_t tick);
+
+// Ticks the world takes to scroll a course gap (course units), rounded up
+// to whole ticks.
+uint32_t simGapTicks(const SimConfig& config, uint32_t gap);
+
+// Ticks from the previous spawn to the next obstacle's.
+uint32_t simSpawnGapTicks(const SimState& state, const SimConfig& config);
+
+// Height of the base of an obstacle of kind `kind` (CourseObstacleKind).
+float simObstacleY(const SimConfig& config, uint8_t kind);
+
+// The course config plays: config.courseFile if set, else generated from
+// config.seed.
+CourseSource simCourseSource(const SimConfig& config);
+
+// Load the next chunk of the course ahead of time, so simUpdate() doesn't
+// have to when it gets there. Cheap when it is already loaded; call it
+// between ticks, e.g. once per frame. Returns false while a streamed
+// course file is still waiting for the bytes of the chunks in use;
+// simUpdate() must not be called until it returns true.
+bool simPrefetchCourse(SimState& state, const SimConfig& config);
+
+// Switch a running game to a new tick rate. Tick counts in the state
+// (spike ages, time in the air, time since the last spawn) are rescaled
+// so play continues from the same positions, to within a tick.
+void simSetTickRate(SimState& state, SimConfig& config, double tickRate);
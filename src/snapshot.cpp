@@ -0,0 +1,43 @@
+#include "snapshot.h"
+
+void SnapshotRing::reset(size_t capacity) {
+    slots.assign(capacity, SimSnapshot());
+    clear();
+}
+
+void SnapshotRing::push(const SimState& state) {
+    if (slots.empty()) {
+        return;
+    }
+    if (count == slots.size()) {
+        head = (head + 1) % slots.size();
+        --count;
+    }
+    simSave(state, slots[(head + count) % slots.size()]);
+    ++count;
+}
+
+// ------------------------------------------------------
+// Snapshots are in tick order, so a binary search finds the newest one
+// at or before a tick
+// ------------------------------------------------------
+const SimSnapshot* SnapshotRing::atOrBefore(uint64_t tick) const {
+    // Count the snapshots at or before `tick` (oldest first)
+    size_t lo = 0;
+    size_t hi = count;
+    while (lo < hi) {
+        size_t mid = lo + (hi - lo) / 2;
+        if (slots[(head + mid) % slots.size()].state.tick <= tick) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+    return lo == 0 ? nullptr : &slots[(head + lo - 1) % slots.size()];
+}
+
+void SnapshotRing::discardAfter(uint64_t tick) {
+    while (count > 0 && fromNewest(0).state.tick > tick) {
+        --count;
+    }
+}
@@ -0,0 +1,76 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+#include <vector>
+
+#include "sim.h"
+
+// ------------------------------------------------------
+// Snapshots of the simulation state, for rewind, rollback and search.
+// SimState is plain data of a fixed size: the spikes live in an inline
+// ring buffer and the course cursor holds its chunks inline. A snapshot is
+// therefore a byte copy of it, and saving or restoring one costs the same
+// whatever is on screen and never allocates. The config is not part of a
+// snapshot; restore into a game running with the same config.
+// (Presentation state such as main.cpp's frame timing isn't either: it is
+// not simulation state.)
+// ------------------------------------------------------
+
+static_assert(std::is_trivially_copyable<SimState>::value,
+              "SimState must stay plain data so it can be snapshotted");
+
+struct SimSnapshot {
+    SimState state;
+};
+
+inline void simSave(const SimState& state, SimSnapshot& snapshot) {
+    memcpy(static_cast<void*>(&snapshot.state), &state, sizeof(SimState));
+}
+
+inline void simRestore(SimState& state, const SimSnapshot& snapshot) {
+    memcpy(static_cast<void*>(&state), &snapshot.state, sizeof(SimState));
+}
+
+// ------------------------------------------------------
+// The most recent snapshots, oldest overwritten first. Storage is
+// allocated once by reset(); push() and the lookups never allocate.
+// Snapshots must be pushed in increasing tick order: after rewinding to
+// an earlier snapshot, discardAfter() drops the ones that no longer
+// happened.
+// ------------------------------------------------------
+class SnapshotRing {
+public:
+    SnapshotRing() = default;
+    explicit SnapshotRing(size_t capacity) { reset(capacity); }
+
+    // Allocate room for `capacity` snapshots, dropping any held
+    void reset(size_t capacity);
+    void clear() { head = count = 0; }
+
+    size_t capacity() const { return slots.size(); }
+    size_t size() const { return count; }
+    bool empty() const { return count == 0; }
+
+    // Save `state` as the newest snapshot
+    void push(const SimState& state);
+
+    // The snapshot `age` pushes ago (0 is the newest); age < size()
+    const SimSnapshot& fromNewest(size_t age) const {
+        return slots[(head + count - 1 - age) % slots.size()];
+    }
+
+    // The newest snapshot taken at or before `tick`, or nullptr if there
+    // is none
+    const SimSnapshot* atOrBefore(uint64_t tick) const;
+
+    // Drop the snapshots taken after `tick`
+    void discardAfter(uint64_t tick);
+
+private:
+    std::vector<SimSnapshot> slots;
+    size_t head = 0; // oldest snapshot
+    size_t count = 0;
+};
@@ -0,0 +1,58 @@
+#include "state_hash.h"
+
+#include <cstring>
+
+#include "hash.h"
+
+const char* const simHashFieldNames[SIM_HASH_FIELD_COUNT] = {
+    "playerY",  "playerVelocity", "isOnGround",      "prevPlayerY", "launchY", "launchVelocity",
+    "airTicks", "course.next",    "ticksSinceSpawn", "spikes",      "tick",
+};
+
+// Hash of one field's value; the field index keeps equal values in
+// different fields from hashing alike
+static uint32_t hashField(SimHashField field, uint64_t value) {
+    return uint32_t(hashMix(value ^ (uint64_t(field) << 56)));
+}
+
+bool SimStateHash::operator==(const SimStateHash& other) const {
+    return memcmp(fields, other.fields, sizeof(fields)) == 0;
+}
+
+uint64_t SimStateHash::combined() const {
+    uint64_t h = 0;
+    for (uint32_t field : fields) {
+        h = hashMix(h ^ field);
+    }
+    return h;
+}
+
+// ------------------------------------------------------
+// Hash every field of the state
+// ------------------------------------------------------
+void simHashState(const SimState& state, SimStateHash& out) {
+    out.fields[SIM_HASH_PLAYER_Y] = hashField(SIM_HASH_PLAYER_Y, hashFloatBits(state.playerY));
+    out.fields[SIM_HASH_PLAYER_VELOCITY] =
+        hashField(SIM_HASH_PLAYER_VELOCITY, hashFloatBits(state.playerVelocity));
+    out.fields[SIM_HASH_ON_GROUND] = hashField(SIM_HASH_ON_GROUND, state.isOnGround);
+    out.fields[SIM_HASH_PREV_PLAYER_Y] = hashField(SIM_HASH_PREV_PLAYER_Y, hashFloatBits(state.prevPlayerY));
+    out.fields[SIM_HASH_LAUNCH_Y] = hashField(SIM_HASH_LAUNCH_Y, hashFloatBits(state.launchY));
+    out.fields[SIM_HASH_LAUNCH_VELOCITY] =
+        hashField(SIM_HASH_LAUNCH_VELOCITY, hashFloatBits(state.launchVelocity));
+    out.fields[SIM_HASH_AIR_TICKS] = hashField(SIM_HASH_AIR_TICKS, state.airTicks);
+    out.fields[SIM_HASH_COURSE] = hashField(SIM_HASH_COURSE, state.course.next);
+    out.fields[SIM_HASH_TICKS_SINCE_SPAWN] =
+        hashField(SIM_HASH_TICKS_SINCE_SPAWN, state.ticksSinceSpawn);
+    out.fields[SIM_HASH_TICK] = hashField(SIM_HASH_TICK, state.tick);
+
+    // Spikes: simUpdate() keeps a running hash of every live spike's y and
+    // spawn tick, updated as spikes spawn and leave, so this is O(1) in
+    // the spike count. x is a closed-form function of the spawn tick
+    // (simSpikeX()); the oldest and newest spikes' x cover that function.
+    uint64_t h = hashMix(state.spikesHash ^ state.spikes.size());
+    if (!state.spikes.empty()) {
+        h = hashMix(h ^ hashFloatBits(state.spikes.front().x) ^
+                    hashFloatBits(state.spikes.back().x) << 32);
+    }
+    out.fields[SIM_HASH_SPIKES] = hashField(SIM_HASH_SPIKES, h);
+}
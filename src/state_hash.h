@@ -0,0 +1,48 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#include "sim.h"
+
+// ------------------------------------------------------
+// Per-tick state hashes for desync and regression detection.
+// Each field of SimState gets its own fast (non-cryptographic) 32-bit
+// hash of its exact bits, so two runs that should be identical (say a
+// wasm recording and its native replay) can be compared tick by tick, and
+// the first tick they differ on names the fields that differ. Hashing
+// reads only live data (the spikes on screen, the course position), never
+// padding or unused ring slots, so equal states always hash equal. It is
+// O(1) per tick: the spikes are hashed incrementally by simUpdate()
+// (SimState::spikesHash), as they spawn and leave.
+// ------------------------------------------------------
+
+enum SimHashField {
+    SIM_HASH_PLAYER_Y,
+    SIM_HASH_PLAYER_VELOCITY,
+    SIM_HASH_ON_GROUND,
+    SIM_HASH_PREV_PLAYER_Y,
+    SIM_HASH_LAUNCH_Y,
+    SIM_HASH_LAUNCH_VELOCITY,
+    SIM_HASH_AIR_TICKS,
+    SIM_HASH_COURSE,           // course.next
+    SIM_HASH_TICKS_SINCE_SPAWN,
+    SIM_HASH_SPIKES,           // every live spike's x, y and spawn tick
+    SIM_HASH_TICK,
+    SIM_HASH_FIELD_COUNT
+};
+
+// SimState member names, by SimHashField
+extern const char* const simHashFieldNames[SIM_HASH_FIELD_COUNT];
+
+struct SimStateHash {
+    uint32_t fields[SIM_HASH_FIELD_COUNT];
+
+    bool operator==(const SimStateHash& other) const;
+    bool operator!=(const SimStateHash& other) const { return !(*this == other); }
+
+    // All fields folded into one value
+    uint64_t combined() const;
+};
+
+void simHashState(const SimState& state, SimStateHash& out);
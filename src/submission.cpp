@@ -0,0 +1,255 @@
+#include "submission.h"
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <condition_variable>
+#include <cstring>
+
+#include "byte_io.h"
+
+static const uint8_t submissionMagic[4] = {'B', 'G', 'S', 'B'};
+static const uint8_t verdictMagic[4] = {'B', 'G', 'S', 'V'};
+static const size_t submissionHeaderSize = 24;
+static const size_t verdictSize = 29;
+
+// ------------------------------------------------------
+// Blocking socket I/O of whole buffers
+// ------------------------------------------------------
+static bool sendAll(int socket, const uint8_t* data, size_t size) {
+    while (size > 0) {
+        ssize_t sent = send(socket, data, size, MSG_NOSIGNAL);
+        if (sent <= 0) {
+            return false;
+        }
+        data += sent;
+        size -= size_t(sent);
+    }
+    return true;
+}
+
+static bool receiveAll(int socket, uint8_t* data, size_t size) {
+    while (size > 0) {
+        ssize_t got = recv(socket, data, size, 0);
+        if (got <= 0) {
+            return false;
+        }
+        data += got;
+        size -= size_t(got);
+    }
+    return true;
+}
+
+// Small messages go out as soon as they are written
+static void setNoDelay(int socket) {
+    int on = 1;
+    setsockopt(socket, IPPROTO_TCP, TCP_NODELAY, &on, sizeof(on));
+}
+
+static sockaddr_in loopback(uint16_t port) {
+    sockaddr_in address = {};
+    address.sin_family = AF_INET;
+    address.sin_port = htons(port);
+    address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    return address;
+}
+
+int submissionConnect(uint16_t port) {
+    int s = socket(AF_INET, SOCK_STREAM, 0);
+    if (s < 0) {
+        return -1;
+    }
+    sockaddr_in address = loopback(port);
+    if (connect(s, (const sockaddr*)&address, sizeof(address)) != 0) {
+        close(s);
+        return -1;
+    }
+    setNoDelay(s);
+    return s;
+}
+
+bool submissionSend(int socket, uint64_t id, uint64_t claimedScore, const std::vector<uint8_t>& replay) {
+    std::vector<uint8_t> header(submissionMagic, submissionMagic + 4);
+    writeU64(header, id);
+    writeU64(header, claimedScore);
+    writeU32(header, uint32_t(replay.size()));
+    return sendAll(socket, header.data(), header.size()) &&
+           sendAll(socket, replay.data(), replay.size());
+}
+
+bool submissionReceive(int socket, SubmissionVerdict& out) {
+    uint8_t bytes[verdictSize];
+    if (!receiveAll(socket, bytes, sizeof(bytes)) || memcmp(bytes, verdictMagic, 4) != 0) {
+        return false;
+    }
+    ByteReader in = {bytes, sizeof(bytes), 4, true};
+    out.id = in.u64();
+    uint8_t result = in.u8();
+    out.result = result < VERIFY_RESULT_COUNT ? VerifyResult(result) : VERIFY_INVALID;
+    out.score = in.u64();
+    out.verifyNanoseconds = in.u64();
+    return in.ok;
+}
+
+void submissionShutdown(int socket) {
+    shutdown(socket, SHUT_RDWR);
+}
+
+void submissionClose(int socket) {
+    close(socket);
+}
+
+// ------------------------------------------------------
+// Server
+// ------------------------------------------------------
+
+// One client connection. Shared by its reader thread and the pool tasks
+// verifying its submissions, which send their verdicts themselves.
+struct SubmissionServer::Connection {
+    int socket;
+    std::mutex sendMutex;
+
+    // Submissions still being verified; the socket is closed at zero
+    std::mutex mutex;
+    std::condition_variable drained;
+    size_t inFlight = 0;
+
+    // Set once the socket is closed, when the reader thread can be joined
+    std::atomic<bool> finished{false};
+
+    void sendVerdict(uint64_t id, const VerifyVerdict& verdict) {
+        std::vector<uint8_t> bytes(verdictMagic, verdictMagic + 4);
+        writeU64(bytes, id);
+        bytes.push_back(uint8_t(verdict.result));
+        writeU64(bytes, verdict.score);
+        writeU64(bytes, uint64_t(verdict.simSeconds * 1e9));
+        std::lock_guard<std::mutex> lock(sendMutex);
+        // A client that left doesn't get its verdict
+        sendAll(socket, bytes.data(), bytes.size());
+    }
+};
+
+SubmissionServer::SubmissionServer(WorkPool& workPool, VerdictCallback callback)
+    : pool(workPool), onVerdict(std::move(callback)) {
+}
+
+SubmissionServer::~SubmissionServer() {
+    stop();
+}
+
+bool SubmissionServer::start(uint16_t port) {
+    listener = socket(AF_INET, SOCK_STREAM, 0);
+    if (listener < 0) {
+        return false;
+    }
+    int on = 1;
+    setsockopt(listener, SOL_SOCKET, SO_REUSEADDR, &on, sizeof(on));
+    sockaddr_in address = loopback(port);
+    socklen_t length = sizeof(address);
+    if (bind(listener, (const sockaddr*)&address, sizeof(address)) != 0 || listen(listener, 64) != 0 ||
+        getsockname(listener, (sockaddr*)&address, &length) != 0) {
+        close(listener);
+        listener = -1;
+        return false;
+    }
+    boundPort = ntohs(address.sin_port);
+    acceptThread = std::thread([this] { acceptLoop(); });
+    return true;
+}
+
+void SubmissionServer::stop() {
+    if (listener < 0) {
+        return;
+    }
+    // Wakes the blocked accept()
+    shutdown(listener, SHUT_RDWR);
+    acceptThread.join();
+    close(listener);
+    listener = -1;
+    for (auto &entry : connectionThreads) {
+        entry.thread.join();
+    }
+    connectionThreads.clear();
+}
+
+void SubmissionServer::reapConnections() {
+    std::lock_guard<std::mutex> lock(connectionsMutex);
+    for (size_t i = 0; i < connectionThreads.size();) {
+        if (connectionThreads[i].connection->finished.load()) {
+            connectionThreads[i].thread.join();
+            if (i + 1 < connectionThreads.size()) {
+                connectionThreads[i] = std::move(connectionThreads.back());
+            }
+            connectionThreads.pop_back();
+        } else {
+            ++i;
+        }
+    }
+}
+
+void SubmissionServer::acceptLoop() {
+    for (;;) {
+        int client = accept(listener, nullptr, nullptr);
+        if (client < 0) {
+            return;
+        }
+        setNoDelay(client);
+        // A long-running server would otherwise keep every closed
+        // connection's thread around until stop()
+        reapConnections();
+        std::shared_ptr<Connection> connection = std::make_shared<Connection>();
+        connection->socket = client;
+        std::lock_guard<std::mutex> lock(connectionsMutex);
+        std::thread thread([this, connection] { serve(connection); });
+        connectionThreads.push_back({std::move(thread), connection});
+    }
+}
+
+// ------------------------------------------------------
+// Read a connection's submissions and queue each for verification, until
+// the client closes it or sends something malformed
+// ------------------------------------------------------
+void SubmissionServer::serve(std::shared_ptr<Connection> connection) {
+    for (;;) {
+        uint8_t header[submissionHeaderSize];
+        if (!receiveAll(connection->socket, header, sizeof(header)) ||
+            memcmp(header, submissionMagic, 4) != 0) {
+            break;
+        }
+        ByteReader in = {header, sizeof(header), 4, true};
+        uint64_t id = in.u64();
+        uint64_t claimedScore = in.u64();
+        uint32_t size = in.u32();
+        if (size > submissionMaxBytes) {
+            break;
+        }
+        std::shared_ptr<std::vector<uint8_t>> replay = std::make_shared<std::vector<uint8_t>>(size);
+        if (!receiveAll(connection->socket, replay->data(), size)) {
+            break;
+        }
+        ++submissions;
+        {
+            std::lock_guard<std::mutex> lock(connection->mutex);
+            ++connection->inFlight;
+        }
+        pool.submit([this, connection, replay, id, claimedScore] {
+            VerifyVerdict verdict = verifyReplay(replay->data(), replay->size(), claimedScore);
+            connection->sendVerdict(id, verdict);
+            if (onVerdict) {
+                onVerdict(verdict, id);
+            }
+            std::lock_guard<std::mutex> lock(connection->mutex);
+            if (--connection->inFlight == 0) {
+                connection->drained.notify_all();
+            }
+        });
+    }
+    // Let the queued verdicts go out before closing
+    std::unique_lock<std::mutex> lock(connection->mutex);
+    connection->drained.wait(lock, [&] { return connection->inFlight == 0; });
+    close(connection->socket);
+    connection->finished = true;
+}
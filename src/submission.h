@@ -0,0 +1,93 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "verifier.h"
+#include "work_pool.h"
+
+// ------------------------------------------------------
+// Score submission endpoint (native builds, POSIX sockets).
+// A local stand-in for the server that accepts high scores: clients
+// stream submissions over TCP, each is verified on a WorkPool (verifier.h)
+// and its verdict is sent back as soon as it is ready, so one connection
+// can have many submissions in flight. Replies carry the id of their
+// submission and may arrive out of order.
+//
+// Wire format, little-endian:
+//   submission: "BGSB", u64 id, u64 claimed score, u32 size, size bytes of replay file
+//   verdict:    "BGSV", u64 id, u8 VerifyResult, u64 score, u64 verify time in ns
+// ------------------------------------------------------
+
+// Largest replay accepted; bigger submissions close the connection
+const uint32_t submissionMaxBytes = 16u << 20;
+
+struct SubmissionVerdict {
+    uint64_t id = 0;
+    VerifyResult result = VERIFY_INVALID;
+    uint64_t score = 0;
+    uint64_t verifyNanoseconds = 0;
+};
+
+// Client side. Connect to the endpoint on the loopback interface; returns
+// a socket, or -1.
+int submissionConnect(uint16_t port);
+bool submissionSend(int socket, uint64_t id, uint64_t claimedScore, const std::vector<uint8_t>& replay);
+// Blocks for the next verdict; false once the connection is closed
+bool submissionReceive(int socket, SubmissionVerdict& out);
+// Wake a thread blocked in submissionReceive() on the socket; it still
+// has to be closed
+void submissionShutdown(int socket);
+void submissionClose(int socket);
+
+class SubmissionServer {
+public:
+    // Called from the pool's threads for every verdict, with the id the
+    // submission came with
+    using VerdictCallback = std::function<void(const VerifyVerdict&, uint64_t id)>;
+
+    SubmissionServer(WorkPool& pool, VerdictCallback onVerdict = nullptr);
+    ~SubmissionServer();
+
+    // Listen on 127.0.0.1:port (0 picks a free port) and start accepting
+    // connections. Returns false if the port can't be bound.
+    bool start(uint16_t port);
+
+    // Stop accepting, and wait for every open connection to be closed by
+    // its client and its verdicts sent
+    void stop();
+
+    uint16_t port() const { return boundPort; }
+
+    // Submissions received so far
+    uint64_t received() const { return submissions.load(); }
+
+private:
+    struct Connection;
+
+    // A connection's reader thread
+    struct ConnectionThread {
+        std::thread thread;
+        std::shared_ptr<Connection> connection;
+    };
+
+    void acceptLoop();
+    void serve(std::shared_ptr<Connection> connection);
+    // Join the threads of connections that have closed
+    void reapConnections();
+
+    WorkPool& pool;
+    VerdictCallback onVerdict;
+    int listener = -1;
+    uint16_t boundPort = 0;
+    std::thread acceptThread;
+    std::mutex connectionsMutex;
+    std::vector<ConnectionThread> connectionThreads;
+    std::atomic<uint64_t> submissions{0};
+};
@@ -0,0 +1,68 @@
+#include "trace.h"
+
+#ifdef TRACING
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+
+// One complete ("ph":"X") event
+struct TraceEvent {
+    const char* name;
+    double startMicros;
+    double durationMicros;
+    uint32_t thread;
+};
+
+static TraceEvent events[traceCapacity];
+static std::atomic<uint64_t> eventCount(0);  // events ever recorded
+static std::atomic<uint32_t> nextThreadId(1);
+
+static const auto traceEpoch = std::chrono::steady_clock::now();
+
+static double nowMicros() {
+    return std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - traceEpoch).count();
+}
+
+static uint32_t currentThreadId() {
+    thread_local uint32_t id = nextThreadId.fetch_add(1, std::memory_order_relaxed);
+    return id;
+}
+
+TraceScope::TraceScope(const char* zoneName) : name(zoneName), startMicros(nowMicros()) {}
+
+TraceScope::~TraceScope() {
+    double end = nowMicros();
+    uint64_t slot = eventCount.fetch_add(1, std::memory_order_relaxed);
+    TraceEvent& event = events[slot % traceCapacity];
+    event.name = name;
+    event.startMicros = startMicros;
+    event.durationMicros = end - startMicros;
+    event.thread = currentThreadId();
+}
+
+void traceClear() {
+    eventCount.store(0, std::memory_order_relaxed);
+}
+
+void traceExportJSON(std::string& out) {
+    uint64_t count = eventCount.load(std::memory_order_acquire);
+    uint64_t first = count > traceCapacity ? count - traceCapacity : 0;
+
+    out.clear();
+    out.reserve(size_t(count - first) * 96 + 64);
+    out += "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[";
+    char line[256];
+    for (uint64_t i = first; i < count; ++i) {
+        const TraceEvent& event = events[i % traceCapacity];
+        snprintf(line, sizeof(line),
+                 "%s\n{\"name\":\"%s\",\"ph\":\"X\",\"ts\":%.3f,\"dur\":%.3f,\"pid\":1,\"tid\":%u}",
+                 i == first ? "" : ",", event.name, event.startMicros, event.durationMicros,
+                 event.thread);
+        out += line;
+    }
+    out += "\n]}\n";
+}
+
+#endif
@@ -0,0 +1,46 @@
+#pragma once
+
+#include <string>
+
+// ------------------------------------------------------
+// Scoped tracing zones exported as Chrome trace_event JSON
+// (load the output in chrome://tracing or https://ui.perfetto.dev).
+// Compiled in only when TRACING is defined; otherwise TRACE_SCOPE expands
+// to nothing and the hot paths carry no tracing code at all.
+//
+// Events go into a preallocated ring that keeps the most recent
+// traceCapacity zones. Recording is lock-free and safe from several
+// threads; export while no zones are being recorded.
+// ------------------------------------------------------
+
+#ifdef TRACING
+
+static const unsigned traceCapacity = 1u << 16;
+
+// Times the enclosing scope. `name` must be a string literal (only the
+// pointer is stored).
+class TraceScope {
+public:
+    explicit TraceScope(const char* name);
+    ~TraceScope();
+
+private:
+    const char* name;
+    double startMicros;
+};
+
+#define TRACE_CONCAT_INNER(a, b) a##b
+#define TRACE_CONCAT(a, b) TRACE_CONCAT_INNER(a, b)
+#define TRACE_SCOPE(name) TraceScope TRACE_CONCAT(traceScope, __LINE__)(name)
+
+// Write the recorded zones, oldest first, as a trace_event JSON document.
+void traceExportJSON(std::string& out);
+
+// Drop everything recorded so far.
+void traceClear();
+
+#else
+
+#define TRACE_SCOPE(name) ((void)0)
+
+#endif
@@ -0,0 +1,129 @@
+#include "verifier.h"
+
+#include <chrono>
+
+#include "fast_forward.h"
+#include "state_hash.h"
+
+const char* const verifyResultNames[VERIFY_RESULT_COUNT] = {"accepted", "wrong-score", "invalid"};
+
+uint64_t verifyScore(const SimConfig& config, uint64_t tickCount,
+                     const std::vector<uint64_t>& collisionTicks) {
+    // A collision ends the stretch on the tick it happens; the next one
+    // starts on the tick after
+    uint64_t best = 0;
+    uint64_t start = 0;
+    for (uint64_t tick : collisionTicks) {
+        best = tick - start > best ? tick - start : best;
+        start = tick + 1;
+    }
+    best = tickCount - start > best ? tickCount - start : best;
+    return uint64_t(double(best) * 1000.0 / config.tickRate);
+}
+
+// The rules scores are ranked under: everything but the seed at its default
+static bool officialRules(const SimConfig& config) {
+    SimConfig official;
+    return config.tickRate == official.tickRate && config.scrollSpeed == official.scrollSpeed &&
+           config.gravity == official.gravity && config.jumpVelocity == official.jumpVelocity &&
+           config.groundY == official.groundY;
+}
+
+static bool sameHash(const SimState& a, const SimState& b) {
+    SimStateHash ha, hb;
+    simHashState(a, ha);
+    simHashState(b, hb);
+    return ha == hb;
+}
+
+// ------------------------------------------------------
+// Run the ticks from state.tick up to `last` (exclusive), fast-forwarding
+// between inputs (fast_forward.h), and checking each state hash on the way
+// if the replay has them
+// ------------------------------------------------------
+static bool runBlock(const Replay& replay, SimState& state, uint64_t last, size_t& nextEvent,
+                     std::vector<uint64_t>& collisionTicks) {
+    const std::vector<ReplayEvent>& events = replay.events;
+    uint64_t interval = replay.hashes.empty() ? 0 : replay.hashInterval;
+    while (state.tick < last) {
+        // Run to the next hash, or the end of the block
+        uint64_t stop = last;
+        if (interval > 0) {
+            uint64_t next = (state.tick / interval + 1) * interval;
+            stop = next < stop ? next : stop;
+        }
+        while (nextEvent < events.size() && events[nextEvent].tick < stop) {
+            const ReplayEvent& event = events[nextEvent++];
+            simFastForward(state, replay.config, event.tick - state.tick, &collisionTicks);
+            if (simUpdate(state, replay.config, event.input)) {
+                collisionTicks.push_back(event.tick);
+            }
+        }
+        simFastForward(state, replay.config, stop - state.tick, &collisionTicks);
+        if (interval > 0 && state.tick % interval == 0) {
+            uint64_t index = state.tick / interval - 1;
+            if (index < replay.hashes.size() && replayStateHash(state) != replay.hashes[index]) {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+// ------------------------------------------------------
+// Re-simulate the replay block by block, checking each keyframe against
+// the state the run reaches
+// ------------------------------------------------------
+static void verify(const Replay& replay, uint64_t claimedScore, VerifyVerdict& verdict) {
+    verdict.ticks = replay.tickCount;
+    if (!officialRules(replay.config)) {
+        verdict.reason = "not played under the official rules";
+        return;
+    }
+    if (double(replay.tickCount) > verifyMaxSeconds * replay.config.tickRate) {
+        verdict.reason = "run too long";
+        return;
+    }
+
+    SimState state;
+    simInit(state, replay.config);
+    std::vector<uint64_t> collisionTicks;
+    size_t nextEvent = 0;
+    for (size_t k = 0; k < replay.keyframes.size(); ++k) {
+        uint64_t first = uint64_t(k) * replay.keyframeInterval;
+        uint64_t last = replay.tickCount - first > replay.keyframeInterval
+                            ? first + replay.keyframeInterval
+                            : replay.tickCount;
+        if (!sameHash(state, replay.keyframes[k].state)) {
+            verdict.reason = "keyframe doesn't match the inputs";
+            return;
+        }
+        if (!runBlock(replay, state, last, nextEvent, collisionTicks)) {
+            verdict.reason = "state hash doesn't match the inputs";
+            return;
+        }
+    }
+
+    verdict.collisions = collisionTicks.size();
+    verdict.score = verifyScore(replay.config, replay.tickCount, collisionTicks);
+    if (claimedScore != verifyNoClaim && claimedScore != verdict.score) {
+        verdict.result = VERIFY_WRONG_SCORE;
+        verdict.reason = "claimed score not reproduced";
+        return;
+    }
+    verdict.result = VERIFY_ACCEPTED;
+}
+
+VerifyVerdict verifyReplay(const uint8_t* data, size_t size, uint64_t claimedScore) {
+    auto start = std::chrono::steady_clock::now();
+    VerifyVerdict verdict;
+    Replay replay;
+    if (replayDeserialize(data, size, replay)) {
+        verify(replay, claimedScore, verdict);
+    } else {
+        verdict.reason = "unreadable replay";
+    }
+    verdict.simSeconds =
+        std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    return verdict;
+}
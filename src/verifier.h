@@ -0,0 +1,54 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "replay.h"
+#include "sim.h"
+
+// ------------------------------------------------------
+// Replay verification for score submissions.
+// A submission is a replay file plus the score its player claims. The
+// verifier re-simulates the replay from its inputs, checks every keyframe
+// (and every state hash, if it has them) against the states it reaches,
+// and recomputes the score. Only replays of the official rules
+// (SimConfig's defaults, any seed) are accepted.
+//
+// The score of a run is its best survival time: the longest stretch of
+// ticks without a collision, in milliseconds of game time.
+// ------------------------------------------------------
+
+enum VerifyResult : uint8_t {
+    VERIFY_ACCEPTED,    // the replay reproduces the claimed score
+    VERIFY_WRONG_SCORE, // a valid replay, but of a different score
+    VERIFY_INVALID,     // unreadable, other rules, or doesn't reproduce its own states
+    VERIFY_RESULT_COUNT
+};
+
+extern const char* const verifyResultNames[VERIFY_RESULT_COUNT];
+
+// Claim for verifying a replay on its own: any score is accepted
+const uint64_t verifyNoClaim = UINT64_MAX;
+
+// Longest run accepted, in seconds of game time, so a crafted file can't
+// tie up a core for long
+const double verifyMaxSeconds = 6.0 * 60.0 * 60.0;
+
+struct VerifyVerdict {
+    VerifyResult result = VERIFY_INVALID;
+    const char* reason = "";  // why it isn't accepted
+    uint64_t score = 0;       // recomputed, if the replay is valid
+    uint64_t ticks = 0;       // length of the run
+    uint64_t collisions = 0;
+    double simSeconds = 0.0;  // time spent verifying
+};
+
+// Score of a run of tickCount ticks that collided on the given ticks
+// (in increasing order)
+uint64_t verifyScore(const SimConfig& config, uint64_t tickCount,
+                     const std::vector<uint64_t>& collisionTicks);
+
+// Verify a serialized replay against a claimed score (or verifyNoClaim).
+// Safe to call from several threads at once.
+VerifyVerdict verifyReplay(const uint8_t* data, size_t size, uint64_t claimedScore);
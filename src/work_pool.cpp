@@ -0,0 +1,106 @@
+#include "work_pool.h"
+
+// The pool and worker index of the current thread, if it is a worker
+static thread_local WorkPool* currentPool = nullptr;
+static thread_local size_t currentWorker = 0;
+
+WorkPool::WorkPool(size_t threadCount) {
+    if (threadCount == 0) {
+        threadCount = std::thread::hardware_concurrency();
+        threadCount = threadCount > 0 ? threadCount : 1;
+    }
+    for (size_t i = 0; i < threadCount; ++i) {
+        workers.emplace_back(new Worker());
+    }
+    for (size_t i = 0; i < threadCount; ++i) {
+        threads.emplace_back([this, i] { run(i); });
+    }
+}
+
+WorkPool::~WorkPool() {
+    wait();
+    {
+        std::lock_guard<std::mutex> lock(sleepMutex);
+        stopping = true;
+    }
+    wake.notify_all();
+    for (auto &thread : threads) {
+        thread.join();
+    }
+}
+
+void WorkPool::submit(std::function<void()> task) {
+    bool fromWorker = currentPool == this;
+    size_t index = fromWorker ? currentWorker : nextWorker++ % workers.size();
+    ++pending;
+    {
+        // The owner takes from the back: a task's own subtasks first, then
+        // outside submissions oldest first
+        std::lock_guard<std::mutex> lock(workers[index]->mutex);
+        if (fromWorker) {
+            workers[index]->tasks.push_back(std::move(task));
+        } else {
+            workers[index]->tasks.push_front(std::move(task));
+        }
+    }
+    ++queued;
+    // Taking the lock orders this with a worker about to sleep, so the
+    // wake-up can't be lost
+    { std::lock_guard<std::mutex> lock(sleepMutex); }
+    wake.notify_one();
+}
+
+void WorkPool::wait() {
+    std::unique_lock<std::mutex> lock(sleepMutex);
+    idle.wait(lock, [this] { return pending.load() == 0; });
+}
+
+// ------------------------------------------------------
+// Own deque from the back, then steal from the front of the others
+// ------------------------------------------------------
+bool WorkPool::take(size_t index, std::function<void()>& task) {
+    {
+        Worker& own = *workers[index];
+        std::lock_guard<std::mutex> lock(own.mutex);
+        if (!own.tasks.empty()) {
+            task = std::move(own.tasks.back());
+            own.tasks.pop_back();
+            --queued;
+            return true;
+        }
+    }
+    for (size_t i = 1; i < workers.size(); ++i) {
+        Worker& victim = *workers[(index + i) % workers.size()];
+        std::lock_guard<std::mutex> lock(victim.mutex);
+        if (!victim.tasks.empty()) {
+            task = std::move(victim.tasks.front());
+            victim.tasks.pop_front();
+            --queued;
+            ++stolen;
+            return true;
+        }
+    }
+    return false;
+}
+
+void WorkPool::run(size_t index) {
+    currentPool = this;
+    currentWorker = index;
+    std::function<void()> task;
+    for (;;) {
+        if (take(index, task)) {
+            task();
+            task = nullptr;
+            if (--pending == 0) {
+                std::lock_guard<std::mutex> lock(sleepMutex);
+                idle.notify_all();
+            }
+            continue;
+        }
+        std::unique_lock<std::mutex> lock(sleepMutex);
+        wake.wait(lock, [this] { return queued.load() > 0 || stopping; });
+        if (stopping && queued.load() == 0) {
+            return;
+        }
+    }
+}
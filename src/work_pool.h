@@ -0,0 +1,61 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// ------------------------------------------------------
+// Work-stealing thread pool (native builds).
+// Every worker has its own deque of tasks, and when it runs out it
+// steals from the other end of another worker's deque, so uneven jobs (a
+// one-hour replay next to a ten-second one) still keep every core busy.
+// Tasks submitted from outside the pool are dealt round-robin and run
+// oldest first; tasks submitted by a running task go on its own worker's
+// deque and run newest first, ahead of the outside ones.
+// ------------------------------------------------------
+class WorkPool {
+public:
+    // 0 threads: one per hardware thread
+    explicit WorkPool(size_t threads = 0);
+    ~WorkPool();
+    WorkPool(const WorkPool&) = delete;
+    WorkPool& operator=(const WorkPool&) = delete;
+
+    size_t threadCount() const { return threads.size(); }
+
+    void submit(std::function<void()> task);
+
+    // Block until every task submitted so far, and every task those
+    // submitted, has finished. Not for use from inside a task.
+    void wait();
+
+    // Tasks taken from another worker's deque so far
+    uint64_t steals() const { return stolen.load(); }
+
+private:
+    struct Worker {
+        std::mutex mutex;
+        std::deque<std::function<void()>> tasks;
+    };
+
+    void run(size_t index);
+    bool take(size_t index, std::function<void()>& task);
+
+    std::vector<std::unique_ptr<Worker>> workers;
+    std::vector<std::thread> threads;
+
+    std::mutex sleepMutex;
+    std::condition_variable wake; // tasks were queued, or the pool is stopping
+    std::condition_variable idle; // pending dropped to zero
+    std::atomic<size_t> queued{0};  // tasks in the deques
+    std::atomic<size_t> pending{0}; // tasks queued or running
+    std::atomic<size_t> nextWorker{0};
+    std::atomic<uint64_t> stolen{0};
+    bool stopping = false;
+};
@@ -0,0 +1,220 @@
+#include "world_batch.h"
+
+#include <algorithm>
+#include <cmath>
+
+#include "ballistics.h"
+#include "collision.h"
+
+// ------------------------------------------------------
+// Allocate the arrays and reset every world
+// ------------------------------------------------------
+void WorldBatch::init(size_t count, const SimConfig& config) {
+    simConfig = config;
+    worldCount = count;
+
+    playerYs.assign(count, 0.0f);
+    prevPlayerYs.assign(count, 0.0f);
+    playerVelocities.assign(count, 0.0f);
+    onGround.assign(count, 1);
+    launchYs.assign(count, 0.0f);
+    launchVelocities.assign(count, 0.0f);
+    airTicks.assign(count, 0);
+
+    tick = 0;
+    courseStart(course, simCourseSource(config));
+    ticksSinceSpawn = 0;
+    spikeHead = 0;
+    spikeTotal = 0;
+    alive.assign(SimState::maxSpikes * count, 0);
+
+    hit.assign(count, 0);
+    jumped.assign(count, 0);
+    noInput.assign(count, 0);
+}
+
+void WorldBatch::reset() {
+    init(worldCount, simConfig);
+}
+
+// ------------------------------------------------------
+// Kernels. Each runs over worlds with no branches in the loop body
+// (selects only) and mirrors simUpdate() operation for operation, so the
+// results are bit-identical to the scalar simulation. They are free
+// functions taking restrict pointers so the compiler can prove the arrays
+// don't alias and vectorize every loop. Once inlined into step() that proof
+// can fall back to runtime alias checks, so each kernel writes only a few
+// arrays; the player update is split into several passes for that reason.
+// ------------------------------------------------------
+
+// Take jump inputs from worlds whose player is on the ground
+static void takeJumps(size_t n, const uint8_t* __restrict in, uint32_t* __restrict ground,
+                      uint32_t* __restrict jumped) {
+    for (size_t w = 0; w < n; ++w) {
+        uint32_t onGnd = ground[w];
+        uint32_t jump = (in[w] & SIM_INPUT_JUMP) & onGnd;
+        ground[w] = onGnd & ~jump;
+        jumped[w] = jump;
+    }
+}
+
+// Start a new arc from the current height for every world that jumped
+static void startJumpArcs(size_t n, const uint32_t* __restrict jumped, const float* __restrict y,
+                          float* __restrict y0, float* __restrict v0, uint32_t* __restrict air,
+                          float jumpVelocity) {
+    for (size_t w = 0; w < n; ++w) {
+        uint32_t jump = jumped[w];
+        float py = y[w];
+        float launchY = y0[w];
+        float launchV = v0[w];
+        uint32_t ticks = air[w];
+        y0[w] = jump ? py : launchY;
+        v0[w] = jump ? jumpVelocity : launchV;
+        air[w] = jump ? 0 : ticks;
+    }
+}
+
+// Player physics: sample each world's arc at its next tick of flight.
+// A world that lands is left with airTicks = 0 for restartLandedArcs().
+static void stepArcs(size_t n, float* __restrict y, float* __restrict v,
+                     uint32_t* __restrict ground, uint32_t* __restrict air,
+                     const float* __restrict y0, const float* __restrict v0,
+                     const SimConfig& config) {
+    const float deltaTime = float(1.0 / config.tickRate);
+    const float gravity = config.gravity;
+    const float groundY = config.groundY;
+
+    for (size_t w = 0; w < n; ++w) {
+        float launchY = y0[w];
+        float launchV = v0[w];
+        uint32_t ticks = air[w] + 1;
+        uint32_t onGnd = ground[w];
+
+        // arcTime(), converting through int32 so it vectorizes everywhere
+        float t = float(int32_t(ticks)) * deltaTime;
+        float py = launchY + arcOffsetAt(launchV, gravity, t);
+        float vel = launchV + gravity * t;
+        uint32_t landed = py < groundY;
+        y[w] = landed ? groundY : py;
+        v[w] = landed ? 0.0f : vel;
+        ground[w] = landed ? 1 : onGnd;
+        air[w] = landed ? 0 : ticks;
+    }
+}
+
+// Start a resting arc for every world whose player landed (or was reset)
+// this tick, i.e. has airTicks = 0 after stepArcs()
+static void restartLandedArcs(size_t n, const uint32_t* __restrict air,
+                              float* __restrict y0, float* __restrict v0, float groundY) {
+    for (size_t w = 0; w < n; ++w) {
+        uint32_t rest = air[w] == 0;
+        float launchY = y0[w];
+        float launchV = v0[w];
+        y0[w] = rest ? groundY : launchY;
+        v0[w] = rest ? 0.0f : launchV;
+    }
+}
+
+// Collide the players with one spike, swept over the tick like
+// simUpdate(). Worlds that have lost the spike never collide with it.
+static void collideSpike(size_t n, const uint32_t* __restrict live, const float* __restrict y0,
+                         const float* __restrict y1, uint32_t* __restrict hits,
+                         float prevX, float x, float spikeY) {
+    for (size_t w = 0; w < n; ++w) {
+        hits[w] |= live[w] & uint32_t(collideSwept(prevX, x, spikeY, y0[w], y1[w]));
+    }
+}
+
+// Stand the players of worlds that collided on the ground
+static void resetHitPlayers(size_t n, const uint32_t* __restrict hits,
+                            float* __restrict y, float* __restrict v, uint32_t* __restrict ground,
+                            float groundY) {
+    for (size_t w = 0; w < n; ++w) {
+        uint32_t h = hits[w];
+        float py = y[w];
+        float vel = v[w];
+        uint32_t onGnd = ground[w];
+        y[w] = h ? groundY : py;
+        v[w] = h ? 0.0f : vel;
+        ground[w] = h ? 1 : onGnd;
+    }
+}
+
+// Restart the arcs of worlds that collided (see restartLandedArcs())
+static void clearHitAirTicks(size_t n, const uint32_t* __restrict hits, uint32_t* __restrict air) {
+    for (size_t w = 0; w < n; ++w) {
+        uint32_t ticks = air[w];
+        air[w] = hits[w] ? 0 : ticks;
+    }
+}
+
+// Remove one spike from the worlds that collided
+static void clearHitSpike(size_t n, uint32_t* __restrict live, const uint32_t* __restrict hits) {
+    for (size_t w = 0; w < n; ++w) {
+        live[w] &= hits[w] ^ 1;
+    }
+}
+
+// ------------------------------------------------------
+// One tick for every world
+// ------------------------------------------------------
+void WorldBatch::step(const uint8_t* inputs, uint8_t* collided) {
+    const size_t n = worldCount;
+    ++tick;
+    std::copy(playerYs.begin(), playerYs.end(), prevPlayerYs.begin());
+    takeJumps(n, inputs ? inputs : noInput.data(), onGround.data(), jumped.data());
+    startJumpArcs(n, jumped.data(), playerYs.data(), launchYs.data(), launchVelocities.data(),
+                  airTicks.data(), simConfig.jumpVelocity);
+    stepArcs(n, playerYs.data(), playerVelocities.data(), onGround.data(), airTicks.data(),
+             launchYs.data(), launchVelocities.data(), simConfig);
+
+    // Spawn, move and cull the shared spikes as simUpdate() does. The one
+    // difference: simUpdate() drops spawns while its own world has
+    // maxSpikes spikes, which courses never come near.
+    if (++ticksSinceSpawn >= simGapTicks(simConfig, courseNext(course).gap)) {
+        ticksSinceSpawn = 0;
+        if (spikeTotal < SimState::maxSpikes) {
+            size_t slot = slotOf(spikeTotal);
+            float y = simObstacleY(simConfig, courseNext(course).kind);
+            spikes[slot] = {simSpikeSpawnX, y, tick - 1};
+            std::fill(alive.begin() + slot * n, alive.begin() + (slot + 1) * n, 1u);
+            ++spikeTotal;
+        }
+        courseAdvance(course, simCourseSource(simConfig));
+    }
+    for (size_t i = 0; i < spikeTotal; ++i) {
+        Spike& spike = spikes[slotOf(i)];
+        spike.x = simSpikeX(simConfig, spike, tick);
+    }
+    while (spikeTotal > 0 && spikes[spikeHead].x < simSpikeDespawnX) {
+        spikeHead = slotOf(1);
+        --spikeTotal;
+    }
+
+    // Only spikes whose sweep crosses the player's column can collide, so
+    // the per-world kernel runs for one or two spikes at most
+    std::fill(hit.begin(), hit.end(), 0u);
+    for (size_t i = 0; i < spikeTotal; ++i) {
+        const Spike& spike = spikes[slotOf(i)];
+        float prevX = simSpikeX(simConfig, spike, tick - 1);
+        if (sweptSpans(prevX, spike.x, simHitHalfWidth)) {
+            collideSpike(n, alive.data() + slotOf(i) * n, prevPlayerYs.data(), playerYs.data(),
+                         hit.data(), prevX, spike.x, spike.y);
+        }
+    }
+
+    resetHitPlayers(n, hit.data(), playerYs.data(), playerVelocities.data(), onGround.data(),
+                    simConfig.groundY);
+    clearHitAirTicks(n, hit.data(), airTicks.data());
+    restartLandedArcs(n, airTicks.data(), launchYs.data(), launchVelocities.data(),
+                      simConfig.groundY);
+    for (size_t i = 0; i < spikeTotal; ++i) {
+        clearHitSpike(n, alive.data() + slotOf(i) * n, hit.data());
+    }
+
+    if (collided) {
+        for (size_t w = 0; w < n; ++w) {
+            collided[w] = uint8_t(hit[w]);
+        }
+    }
+}
@@ -0,0 +1,75 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "sim.h"
+
+// ------------------------------------------------------
+// Many independent games stepped together, for bot training and balance
+// sweeps. State is stored as structure-of-arrays (one array per field,
+// indexed by world) and every world runs the same branch-free kernel, so
+// the compiler can vectorize the per-world loops (SSE/AVX natively,
+// simd128 in wasm). Each world follows exactly the same rules as
+// simUpdate(): a world given the same inputs produces the same floats.
+// ------------------------------------------------------
+class WorldBatch {
+public:
+    // Allocate worldCount worlds sharing one config, all freshly reset.
+    void init(size_t worldCount, const SimConfig& config);
+
+    // Reset every world to the start of a new game.
+    void reset();
+
+    // Advance every world by one tick. inputs holds one SimInputBits mask
+    // per world (nullptr for no input). If collided is given, collided[w]
+    // is set to 1 when world w hit a spike this tick (and was reset), else 0.
+    void step(const uint8_t* inputs, uint8_t* collided);
+
+    size_t size() const { return worldCount; }
+    size_t spikeSlotCount() const { return SimState::maxSpikes; }
+    const SimConfig& config() const { return simConfig; }
+
+    // Per-world state, indexed by world
+    const float* playerY() const { return playerYs.data(); }
+    const float* playerVelocity() const { return playerVelocities.data(); }
+    const uint32_t* isOnGround() const { return onGround.data(); }
+
+    // Every world plays the same course, so spikes spawn and move in
+    // lockstep and are stored once per batch (index 0 = leftmost). A world
+    // that collided has lost the spikes that were alive at the time:
+    // spikeAlive(i)[w] is 0 for them.
+    size_t spikeCount() const { return spikeTotal; }
+    const Spike& spike(size_t i) const { return spikes[slotOf(i)]; }
+    const uint32_t* spikeAlive(size_t i) const { return alive.data() + slotOf(i) * worldCount; }
+
+private:
+    size_t slotOf(size_t i) const { return (spikeHead + i) % SimState::maxSpikes; }
+
+    SimConfig simConfig;
+    size_t worldCount = 0;
+
+    std::vector<float> playerYs;
+    std::vector<float> prevPlayerYs;     // at the start of the tick, for swept collision
+    std::vector<float> playerVelocities;
+    std::vector<uint32_t> onGround;
+    std::vector<float> launchYs;         // current arc, as in SimState
+    std::vector<float> launchVelocities;
+    std::vector<uint32_t> airTicks;
+
+    // Shared course and spikes, as in SimState; the spikes are a ring of
+    // maxSpikes slots
+    uint64_t tick = 0;
+    CourseCursor course;
+    uint32_t ticksSinceSpawn = 0;
+    Spike spikes[SimState::maxSpikes];
+    size_t spikeHead = 0;
+    size_t spikeTotal = 0;
+    std::vector<uint32_t> alive; // slot-major: maxSpikes x worldCount
+
+    // Per-tick scratch masks (0 or 1)
+    std::vector<uint32_t> hit;
+    std::vector<uint32_t> jumped;
+    std::vector<uint8_t> noInput;    // all zeros, used when step() gets no inputs
+};